@@ -0,0 +1,531 @@
+#include "alloc_tracker.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <cxxabi.h>
+#include <execinfo.h>
+#include <sys/mman.h>
+
+/*
+ * The replacement operators are defined at the end of the file, all of them go through tracked_allocate and tracked_release.
+ * Nothing in here uses operator new itself (the tables are mapped with mmap, the report uses malloc).
+ */
+
+namespace {
+
+const int max_stack_depth = 16;
+// power of two, a site is looked for in at most max_probes consecutive slots
+const std::size_t table_size = 4096;
+const std::size_t max_probes = 16;
+const int max_tables = 1024;
+
+const std::uint64_t header_magic = 0xa7;
+const std::uint64_t size_mask = (std::uint64_t(1) << 48) - 1;
+
+enum allocation_form { single_form = 0, array_form = 1, aligned_single_form = 2, aligned_array_form = 3 };
+const char * const delete_names[] = { "delete", "delete[]", "aligned delete", "aligned delete[]" };
+
+
+class site_statistics;
+
+class allocation_header {
+	public:
+		// size (bits 0-47), form (48-49), log2 of the distance to the start of the malloc block (50-55), magic (56-63)
+		std::uint64_t word;
+		// the entry of the call site in the table of the allocating thread, null if the allocation is not counted
+		site_statistics * entry;
+};
+
+
+/*
+ * The counters are only written by the thread owning the table (load + store, no read-modify-write), atomic so that the
+ * report may read them while other threads are still running.
+ */
+typedef std::atomic<std::uint64_t> counter;
+
+inline void add(counter & target, std::uint64_t value) {
+	target.store(target.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+
+class site_statistics {
+	public:
+		std::atomic<void *> site;
+		counter allocations, frees, allocated_bytes, freed_bytes;
+		// bit mask of the allocation forms
+		std::atomic<std::uint32_t> forms;
+
+		counter mismatches;
+		std::atomic<void *> mismatch_site;
+		std::atomic<std::uint32_t> mismatch_form;
+
+		std::atomic<int> stack_depth;
+		void * stack[max_stack_depth];
+};
+
+
+class site_table {
+	public:
+		site_statistics sites[table_size];
+		// all sites which did not fit
+		site_statistics other;
+
+		counter invalid_frees;
+		std::atomic<void *> invalid_site;
+};
+
+
+// registered tables (mapped memory is zero, which is a valid empty table)
+std::atomic<site_table *> tables[max_tables];
+std::atomic<int> table_count (0);
+
+thread_local site_table * thread_table = nullptr;
+thread_local bool untracked_thread = false;
+
+// the site of the last allocation of the thread and its entry
+thread_local void * last_site = nullptr;
+thread_local site_statistics * last_entry = nullptr;
+
+
+site_table * current_table() {
+	site_table * table = thread_table;
+	if (table != nullptr || untracked_thread) { return table; }
+
+	int index = table_count.fetch_add(1, std::memory_order_relaxed);
+	void * memory = (index < max_tables) ?
+		mmap(nullptr, sizeof(site_table), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0) : MAP_FAILED;
+	if (memory == MAP_FAILED) {
+		untracked_thread = true;
+		return nullptr;
+	}
+
+	table = static_cast<site_table *>(memory);
+	tables[index].store(table, std::memory_order_release);
+	thread_table = table;
+	return table;
+}
+
+
+site_statistics * find_site(site_table * table, void * site, bool & created) {
+	std::size_t slot = (reinterpret_cast<std::uintptr_t>(site)*0x9e3779b97f4a7c15ull) >> 52;
+	for (std::size_t probe=0; probe<max_probes; probe++) {
+		site_statistics & entry = table->sites[(slot + probe) & (table_size - 1)];
+		void * entry_site = entry.site.load(std::memory_order_relaxed);
+		if (entry_site == site) { return &entry; }
+		if (entry_site == nullptr) {
+			entry.site.store(site, std::memory_order_relaxed);
+			created = true;
+			return &entry;
+		}
+	}
+	return &table->other;
+}
+
+
+void record_stack(site_statistics * entry, void * site) {
+	/*
+	 * The stack starts at the caller of operator new (the frame with the return address site).
+	 */
+	void * frames[max_stack_depth + 8];
+	int depth = backtrace(frames, max_stack_depth + 8);
+	int first = 0;
+	while (first < depth && frames[first] != site) { first++; }
+	if (first == depth) { first = 0; }
+
+	int stored = std::min(depth - first, max_stack_depth);
+	for (int i=0; i<stored; i++) { entry->stack[i] = frames[first + i]; }
+	entry->stack_depth.store(stored, std::memory_order_release);
+}
+
+
+__attribute__((always_inline)) inline void * tracked_allocate(std::size_t size, int form, std::size_t alignment, void * site) {
+	std::size_t offset = std::max(alignment, sizeof(allocation_header));
+	if (size > size_mask) { return nullptr; }
+
+	void * memory;
+	for (;;) {
+		if (offset == sizeof(allocation_header)) { memory = std::malloc(size + offset); }
+		else if (posix_memalign(&memory, offset, size + offset) != 0) { memory = nullptr; }
+		if (memory != nullptr) { break; }
+
+		std::new_handler handler = std::get_new_handler();
+		if (handler == nullptr) { return nullptr; }
+		handler();
+	}
+
+	char * pointer = static_cast<char *>(memory) + offset;
+	allocation_header * header = reinterpret_cast<allocation_header *>(pointer) - 1;
+	header->word = size | (std::uint64_t(form) << 48) | (std::uint64_t(__builtin_ctzll(offset)) << 50) | (header_magic << 56);
+	header->entry = nullptr;
+
+	site_table * table = current_table();
+	if (table != nullptr) {
+		// loops allocate at the same site again and again
+		site_statistics * entry = last_entry;
+		if (entry == nullptr || last_site != site) {
+			bool created = false;
+			entry = find_site(table, site, created);
+			if (created) { record_stack(entry, site); }
+			last_site = site;
+			last_entry = entry;
+		}
+
+		add(entry->allocations, 1);
+		add(entry->allocated_bytes, size);
+		std::uint32_t forms = entry->forms.load(std::memory_order_relaxed);
+		if ((forms & (1u << form)) == 0) { entry->forms.store(forms | (1u << form), std::memory_order_relaxed); }
+		header->entry = entry;
+	}
+	return pointer;
+}
+
+
+__attribute__((always_inline)) inline void tracked_release(void * pointer, int form, void * delete_site) {
+	if (pointer == nullptr) { return; }
+
+	allocation_header * header = static_cast<allocation_header *>(pointer) - 1;
+	std::uint64_t word = header->word;
+	site_table * table = current_table();
+
+	// not from operator new or deleted before: reported, not freed
+	if ((word >> 56) != header_magic) {
+		if (table != nullptr) {
+			add(table->invalid_frees, 1);
+			if (table->invalid_site.load(std::memory_order_relaxed) == nullptr) {
+				table->invalid_site.store(delete_site, std::memory_order_relaxed);
+			}
+		}
+		return;
+	}
+
+	int allocation_form = (word >> 48) & 3;
+	std::size_t offset = std::size_t(1) << ((word >> 50) & 63);
+
+	site_statistics * entry = header->entry;
+	if (table != nullptr && entry != nullptr) {
+		// memory of another thread counts in the entry of the same site in this table
+		if (entry < table->sites || entry > &table->other) {
+			void * site = entry->site.load(std::memory_order_relaxed);
+			bool created = false;
+			entry = (site != nullptr) ? find_site(table, site, created) : &table->other;
+		}
+		add(entry->frees, 1);
+		add(entry->freed_bytes, word & size_mask);
+		if (allocation_form != form) {
+			add(entry->mismatches, 1);
+			entry->mismatch_site.store(delete_site, std::memory_order_relaxed);
+			entry->mismatch_form.store(form, std::memory_order_relaxed);
+		}
+	}
+
+	header->word = 0;
+	std::free(static_cast<char *>(pointer) - offset);
+}
+
+
+/*
+ * Report: the entries of all tables are copied into one array, sorted by site and merged.
+ */
+
+class site_summary {
+	public:
+		void * site;
+		std::uint64_t allocations, frees, allocated_bytes, freed_bytes, mismatches;
+		std::uint32_t forms, mismatch_form;
+		void * mismatch_site;
+		int stack_depth;
+		void * const * stack;
+
+		std::int64_t live_bytes() const { return allocated_bytes - freed_bytes; }
+};
+
+
+int compare_sites(const void * a, const void * b) {
+	std::uintptr_t x = reinterpret_cast<std::uintptr_t>(static_cast<const site_summary *>(a)->site);
+	std::uintptr_t y = reinterpret_cast<std::uintptr_t>(static_cast<const site_summary *>(b)->site);
+	return (x < y) ? -1 : (x > y);
+}
+
+
+int compare_live_bytes(const void * a, const void * b) {
+	std::int64_t x = static_cast<const site_summary *>(a)->live_bytes();
+	std::int64_t y = static_cast<const site_summary *>(b)->live_bytes();
+	return (x > y) ? -1 : (x < y);
+}
+
+
+void summarize(const site_statistics & entry, site_summary & summary) {
+	summary.site = entry.site.load(std::memory_order_relaxed);
+	summary.allocations = entry.allocations.load(std::memory_order_relaxed);
+	summary.frees = entry.frees.load(std::memory_order_relaxed);
+	summary.allocated_bytes = entry.allocated_bytes.load(std::memory_order_relaxed);
+	summary.freed_bytes = entry.freed_bytes.load(std::memory_order_relaxed);
+	summary.mismatches = entry.mismatches.load(std::memory_order_relaxed);
+	summary.forms = entry.forms.load(std::memory_order_relaxed);
+	summary.mismatch_form = entry.mismatch_form.load(std::memory_order_relaxed);
+	summary.mismatch_site = entry.mismatch_site.load(std::memory_order_relaxed);
+	summary.stack_depth = entry.stack_depth.load(std::memory_order_acquire);
+	summary.stack = entry.stack;
+}
+
+
+void merge(site_summary & target, const site_summary & source) {
+	target.allocations += source.allocations;
+	target.frees += source.frees;
+	target.allocated_bytes += source.allocated_bytes;
+	target.freed_bytes += source.freed_bytes;
+	target.forms |= source.forms;
+	if (source.mismatches > 0) {
+		target.mismatches += source.mismatches;
+		target.mismatch_site = source.mismatch_site;
+		target.mismatch_form = source.mismatch_form;
+	}
+	if (target.stack_depth == 0) {
+		target.stack_depth = source.stack_depth;
+		target.stack = source.stack;
+	}
+}
+
+
+void print_frames(std::FILE * stream, void * const * frames, int depth) {
+	/*
+	 * backtrace_symbols gives "binary(mangled_name+0x1f) [0x4011a2]", the name is demangled if possible.
+	 */
+	char ** symbols = backtrace_symbols(frames, depth);
+	for (int i=0; i<depth; i++) {
+		const char * line = (symbols != nullptr) ? symbols[i] : "?";
+		const char * open = std::strchr(line, '(');
+		const char * plus = (open != nullptr) ? std::strchr(open, '+') : nullptr;
+
+		char * demangled = nullptr;
+		if (open != nullptr && plus != nullptr && plus > open + 1) {
+			std::size_t length = plus - open - 1;
+			char * mangled = static_cast<char *>(std::malloc(length + 1));
+			std::memcpy(mangled, open + 1, length);
+			mangled[length] = 0;
+			int status;
+			demangled = abi::__cxa_demangle(mangled, nullptr, nullptr, &status);
+			std::free(mangled);
+		}
+
+		if (demangled != nullptr) {
+			std::fprintf(stream, "\t\t#%d %s (%s)\n", i, demangled, line);
+			std::free(demangled);
+		}
+		else { std::fprintf(stream, "\t\t#%d %s\n", i, line); }
+	}
+	std::free(symbols);
+}
+
+
+const char * form_list(std::uint32_t forms) {
+	static const char * const lists[] = { "", "new", "new[]", "new and new[]" };
+	if (forms & 12) { return (forms & 3) ? "new and aligned new" : "aligned new"; }
+	return lists[forms & 3];
+}
+
+}
+
+
+void alloc_tracker_report(std::FILE * stream) {
+	int count = std::min(table_count.load(std::memory_order_relaxed), max_tables);
+
+	std::size_t used = 0;
+	for (int t=0; t<count; t++) {
+		site_table * table = tables[t].load(std::memory_order_acquire);
+		if (table == nullptr) { continue; }
+		for (std::size_t i=0; i<table_size; i++) { used += table->sites[i].site.load(std::memory_order_relaxed) != nullptr; }
+		used++;
+	}
+
+	site_summary * summaries = static_cast<site_summary *>(std::calloc(used + 1, sizeof(site_summary)));
+	if (summaries == nullptr) { return; }
+
+	std::size_t filled = 0;
+	std::uint64_t invalid_frees = 0;
+	void * invalid_site = nullptr;
+	for (int t=0; t<count; t++) {
+		site_table * table = tables[t].load(std::memory_order_acquire);
+		if (table == nullptr) { continue; }
+		for (std::size_t i=0; i<table_size && filled<used; i++) {
+			if (table->sites[i].site.load(std::memory_order_relaxed) != nullptr) { summarize(table->sites[i], summaries[filled++]); }
+		}
+		// the other sites are merged under the site null
+		if (filled < used) {
+			summarize(table->other, summaries[filled]);
+			summaries[filled++].site = nullptr;
+		}
+
+		std::uint64_t invalid = table->invalid_frees.load(std::memory_order_relaxed);
+		if (invalid > 0 && invalid_site == nullptr) { invalid_site = table->invalid_site.load(std::memory_order_relaxed); }
+		invalid_frees += invalid;
+	}
+
+	std::qsort(summaries, filled, sizeof(site_summary), compare_sites);
+	std::size_t sites = 0;
+	for (std::size_t i=0; i<filled; i++) {
+		if (sites > 0 && summaries[sites - 1].site == summaries[i].site) { merge(summaries[sites - 1], summaries[i]); }
+		else { summaries[sites++] = summaries[i]; }
+	}
+
+	std::uint64_t allocations = 0, frees = 0, allocated_bytes = 0, freed_bytes = 0, mismatches = 0;
+	std::size_t leaking_sites = 0;
+	for (std::size_t i=0; i<sites; i++) {
+		allocations += summaries[i].allocations;
+		frees += summaries[i].frees;
+		allocated_bytes += summaries[i].allocated_bytes;
+		freed_bytes += summaries[i].freed_bytes;
+		mismatches += summaries[i].mismatches;
+		leaking_sites += summaries[i].allocations > summaries[i].frees;
+	}
+
+	std::fprintf(stream, "alloc_tracker: %llu allocations (%llu bytes), %llu deletes in %d threads at %zu call sites\n",
+		(unsigned long long) allocations, (unsigned long long) allocated_bytes, (unsigned long long) frees, count, sites);
+	std::fprintf(stream, "alloc_tracker: %llu allocations (%llu bytes) not deleted at %zu call sites, %llu mismatched deletes, "
+		"%llu invalid deletes\n", (unsigned long long) (allocations - frees), (unsigned long long) (allocated_bytes - freed_bytes),
+		leaking_sites, (unsigned long long) mismatches, (unsigned long long) invalid_frees);
+
+	for (std::size_t i=0; i<sites; i++) {
+		const site_summary & site = summaries[i];
+		if (site.mismatches == 0) { continue; }
+		std::fprintf(stream, "mismatch: %llu times %s on memory from %s, deleted at\n", (unsigned long long) site.mismatches,
+			delete_names[site.mismatch_form & 3], form_list(site.forms));
+		print_frames(stream, &site.mismatch_site, 1);
+		std::fprintf(stream, "\tallocated at\n");
+		print_frames(stream, site.stack, site.stack_depth);
+	}
+
+	if (invalid_frees > 0) {
+		std::fprintf(stream, "invalid: %llu deletes of pointers not from operator new (or deleted twice), the first at\n",
+			(unsigned long long) invalid_frees);
+		print_frames(stream, &invalid_site, 1);
+	}
+
+	// the largest leaks
+	const std::size_t max_reported = 20;
+	std::qsort(summaries, sites, sizeof(site_summary), compare_live_bytes);
+	for (std::size_t i=0; i<sites && i<max_reported; i++) {
+		const site_summary & site = summaries[i];
+		if (site.allocations <= site.frees) { break; }
+		std::fprintf(stream, "leak: %lld bytes in %llu of %llu allocations (%s) %s\n", (long long) site.live_bytes(),
+			(unsigned long long) (site.allocations - site.frees), (unsigned long long) site.allocations, form_list(site.forms),
+			(site.site == nullptr) ? "at other call sites (site table full)" : "allocated at");
+		print_frames(stream, site.stack, site.stack_depth);
+	}
+	if (leaking_sites > max_reported) {
+		std::fprintf(stream, "leak: %zu more call sites\n", leaking_sites - max_reported);
+	}
+
+	std::free(summaries);
+}
+
+
+std::size_t alloc_tracker_live_bytes() {
+	std::int64_t live = 0;
+	int count = std::min(table_count.load(std::memory_order_relaxed), max_tables);
+	for (int t=0; t<count; t++) {
+		site_table * table = tables[t].load(std::memory_order_acquire);
+		if (table == nullptr) { continue; }
+		for (std::size_t i=0; i<=table_size; i++) {
+			const site_statistics & entry = (i < table_size) ? table->sites[i] : table->other;
+			live += entry.allocated_bytes.load(std::memory_order_relaxed) - entry.freed_bytes.load(std::memory_order_relaxed);
+		}
+	}
+	return live;
+}
+
+
+// after the destructors of static objects (which may still delete)
+__attribute__((destructor)) static void report_at_exit() {
+	alloc_tracker_report(stderr);
+}
+
+
+void * operator new (std::size_t size) {
+	void * pointer = tracked_allocate(size, single_form, 0, __builtin_return_address(0));
+	if (pointer == nullptr) { throw std::bad_alloc(); }
+	return pointer;
+}
+
+void * operator new[] (std::size_t size) {
+	void * pointer = tracked_allocate(size, array_form, 0, __builtin_return_address(0));
+	if (pointer == nullptr) { throw std::bad_alloc(); }
+	return pointer;
+}
+
+void * operator new (std::size_t size, const std::nothrow_t &) noexcept {
+	return tracked_allocate(size, single_form, 0, __builtin_return_address(0));
+}
+
+void * operator new[] (std::size_t size, const std::nothrow_t &) noexcept {
+	return tracked_allocate(size, array_form, 0, __builtin_return_address(0));
+}
+
+void operator delete (void * pointer) noexcept { tracked_release(pointer, single_form, __builtin_return_address(0)); }
+void operator delete[] (void * pointer) noexcept { tracked_release(pointer, array_form, __builtin_return_address(0)); }
+
+void operator delete (void * pointer, const std::nothrow_t &) noexcept {
+	tracked_release(pointer, single_form, __builtin_return_address(0));
+}
+
+void operator delete[] (void * pointer, const std::nothrow_t &) noexcept {
+	tracked_release(pointer, array_form, __builtin_return_address(0));
+}
+
+#if __cpp_sized_deallocation
+void operator delete (void * pointer, std::size_t) noexcept { tracked_release(pointer, single_form, __builtin_return_address(0)); }
+void operator delete[] (void * pointer, std::size_t) noexcept { tracked_release(pointer, array_form, __builtin_return_address(0)); }
+#endif
+
+#if __cpp_aligned_new
+void * operator new (std::size_t size, std::align_val_t alignment) {
+	void * pointer = tracked_allocate(size, aligned_single_form, std::size_t(alignment), __builtin_return_address(0));
+	if (pointer == nullptr) { throw std::bad_alloc(); }
+	return pointer;
+}
+
+void * operator new[] (std::size_t size, std::align_val_t alignment) {
+	void * pointer = tracked_allocate(size, aligned_array_form, std::size_t(alignment), __builtin_return_address(0));
+	if (pointer == nullptr) { throw std::bad_alloc(); }
+	return pointer;
+}
+
+void * operator new (std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+	return tracked_allocate(size, aligned_single_form, std::size_t(alignment), __builtin_return_address(0));
+}
+
+void * operator new[] (std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+	return tracked_allocate(size, aligned_array_form, std::size_t(alignment), __builtin_return_address(0));
+}
+
+void operator delete (void * pointer, std::align_val_t) noexcept {
+	tracked_release(pointer, aligned_single_form, __builtin_return_address(0));
+}
+
+void operator delete[] (void * pointer, std::align_val_t) noexcept {
+	tracked_release(pointer, aligned_array_form, __builtin_return_address(0));
+}
+
+void operator delete (void * pointer, std::align_val_t, const std::nothrow_t &) noexcept {
+	tracked_release(pointer, aligned_single_form, __builtin_return_address(0));
+}
+
+void operator delete[] (void * pointer, std::align_val_t, const std::nothrow_t &) noexcept {
+	tracked_release(pointer, aligned_array_form, __builtin_return_address(0));
+}
+
+#if __cpp_sized_deallocation
+void operator delete (void * pointer, std::size_t, std::align_val_t) noexcept {
+	tracked_release(pointer, aligned_single_form, __builtin_return_address(0));
+}
+
+void operator delete[] (void * pointer, std::size_t, std::align_val_t) noexcept {
+	tracked_release(pointer, aligned_array_form, __builtin_return_address(0));
+}
+#endif
+#endif
@@ -0,0 +1,39 @@
+/* FILE ALLOC_TRACKER.HPP */
+#ifndef FILE_ALLOC_TRACKER_HPP
+#define FILE_ALLOC_TRACKER_HPP
+
+#include <cstddef>
+#include <cstdio>
+
+/*
+ * In-process allocation tracker, a fast alternative to valgrind --leak-check for the new/delete of a program:
+ * link alloc_tracker.o into the program (with -rdynamic for function names in the report), nothing else has to change.
+ *
+ * alloc_tracker.cpp replaces all global forms of operator new and operator delete (single and array, nothrow, sized and
+ * aligned). Every allocation gets a 16 byte header with its size, its form and the entry of its call site (the return
+ * address of operator new). The statistics per call site (allocations, frees, bytes) are kept in a hash table per thread, so
+ * the counting needs neither locks nor atomic operations; a delete in another thread counts in the table of that thread.
+ * The call stack is only recorded for the first allocation of every call site in every thread (backtrace() is slow).
+ * The hash table is skipped when a thread allocates at the same site as before and when it deletes its own memory, so a
+ * new/delete pair costs about 1-3 ns more than malloc/free (make overhead: tracked/untracked per workload of
+ * tracker_benchmark.cpp), plus the memory of the headers.
+ *
+ * At exit (after the destructors of static objects) a report is written to stderr:
+ *	leaks        call sites with allocations which were never deleted, sorted by the live bytes, with their call stack
+ *	mismatches   delete on memory from new[] (or delete[] on new, aligned on unaligned), with the site of the delete
+ *	invalid      deletes of pointers which are not from operator new or were already deleted
+ *
+ * The memory is freed correctly in spite of a mismatch, invalid pointers are not freed.
+ *
+ * Limits: the call site of allocations made inside compiled library code (e.g. std::string) is in the library, all of them
+ * count as one site with the stack of the first allocation. Up to 4096 call sites per thread are told apart (the others are
+ * counted together), threads after the 1024th are not counted.
+ */
+
+// writes the report (as at exit) to the given stream, e.g. at a checkpoint of a long running program
+void alloc_tracker_report(std::FILE * stream);
+
+// bytes allocated with operator new and not deleted yet (in all threads)
+std::size_t alloc_tracker_live_bytes();
+
+#endif /* FILE_ALLOC_TRACKER_HPP */
@@ -1,9 +1,10 @@
 #include <iostream>
-#include <random>
 #include <functional>
+#include <string>
+#include <vector>
 
-static const int target = 1000;
-
+#include "bulk_random.hpp"
+#include "weighting.hpp"
 
 void simple_leak(int value) {
 
@@ -24,35 +25,16 @@ void bad_memory_free(int value) {
 }
 
 
-std::function<int(int)> function_builder(int value) {
-	if (value < target/10.) {
-		return [](int x) { return x*2; };
-	}
-	else if (value < target/4.) {
-		return [](int x) { return x*4; };
-	}
-	else if (value < target/2.) {
-		return [](int x) { return x/2; };
-	}
-	else if (value < 2.*target/3.) {
-		return [](int x) { return x/4; };
-	}
-	else if (value < 9.*target/10.) {
-		return [](int x) { return x/3; };
-	}
-	else { return nullptr; }
-}
-
-
-double leak_or_no_leak(int count) {
+double leak_or_no_leak(int count, std::uint64_t seed) {
 
 	int * values = new int[count];
 	std::function<int(int)> weighter = function_builder(count);
 
-	std::random_device rnd;
+	std::vector<std::uint32_t> random_values (count);
+	fill_random_bits(random_values.data(), count, seed);
 
 	for (int i=0; i<count; i++) {
-		values[i] = weighter(rnd());
+		values[i] = weighter(random_values[i]);
 	}
 
 	double result = 0;
@@ -65,20 +47,23 @@ double leak_or_no_leak(int count) {
 
 void mean_sum(int runs) {
 
-	std::random_device rnd;
+	xoshiro256 rnd (1);
 	for (int i=0; i<runs; i++) {
-		int count = 900.*rnd()/rnd.max();
+		int count = 900.*rnd.uniform();
 
-		try { leak_or_no_leak(count); }
+		try { leak_or_no_leak(count, rnd()); }
 		catch (...) { }
 	}
 
 }
 
 
-int main() {
-	//simple_leak(10);
-	//bad_memory_free(10);
+int main(int argc, char **argv) {
+	// ./leak_simple.out [simple_leak] [bad_memory_free]
+	for (int i=1; i<argc; i++) {
+		if (std::string(argv[i]) == "simple_leak") { simple_leak(10); }
+		if (std::string(argv[i]) == "bad_memory_free") { bad_memory_free(10); }
+	}
 	mean_sum(100);
 
 	return 0;
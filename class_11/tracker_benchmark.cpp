@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bulk_random.hpp"
+
+/*
+ * Allocation heavy workloads to measure the overhead of alloc_tracker.o: the same source is linked without the tracker
+ * (tracker_benchmark.out) and with it (tracker_benchmark_tracked.out), make overhead runs both and prints the ratio of the
+ * times per workload. Every workload is run repetitions times and the best time is reported (the differences are a few
+ * nanoseconds per allocation, less than the noise of a single run).
+ *
+ * Usage: ./tracker_benchmark.out [threads [repetitions]]   (default 1 thread, every thread runs all workloads, 3 repetitions)
+ *
+ *	map      10^6 inserts into and erases from std::map<int, int> (one node per element)
+ *	strings  10^6 std::strings of 20 to 100 characters in a std::vector, and a copy of each in a std::unique_ptr
+ *	list     10^7 push_back/pop_front of std::list<double>
+ *	arrays   10^5 new[]/delete[] of 100 to 10000 doubles, which are summed (allocation plus some work on the memory)
+ */
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+static double map_workload(std::uint64_t seed) {
+	std::vector<std::uint32_t> keys (1000000);
+	fill_random_bits(keys.data(), keys.size(), seed);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::map<int, int> map;
+	for (std::size_t i=0; i<keys.size(); i++) { map[keys[i] % 4000000] = i; }
+	for (std::size_t i=0; i<keys.size(); i+=2) { map.erase(keys[i] % 4000000); }
+	return seconds_since(start);
+}
+
+
+static double string_workload(std::uint64_t seed) {
+	std::vector<std::uint32_t> lengths (1000000);
+	fill_random_bits(lengths.data(), lengths.size(), seed);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::vector<std::string> strings;
+	for (std::size_t i=0; i<lengths.size(); i++) { strings.push_back(std::string(20 + lengths[i] % 81, 'a' + i % 26)); }
+	std::vector<std::unique_ptr<std::string>> sorted;
+	for (std::size_t i=0; i<strings.size(); i++) { sorted.emplace_back(new std::string(strings[i])); }
+	return seconds_since(start);
+}
+
+
+static double list_workload() {
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::list<double> list;
+	for (int i=0; i<1000; i++) { list.push_back(i); }
+	for (int i=0; i<10000000; i++) {
+		list.push_back(list.front() + 1.);
+		list.pop_front();
+	}
+	return seconds_since(start);
+}
+
+
+static double array_workload(std::uint64_t seed) {
+	std::vector<std::uint32_t> sizes (100000);
+	fill_random_bits(sizes.data(), sizes.size(), seed);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	double total = 0;
+	for (std::size_t i=0; i<sizes.size(); i++) {
+		std::size_t size = 100 + sizes[i] % 9901;
+		double * values = new double[size];
+		for (std::size_t j=0; j<size; j++) { values[j] = j; }
+		for (std::size_t j=0; j<size; j++) { total += values[j]; }
+		delete[] values;
+	}
+	if (total < 0) { std::cout << total << std::endl; }
+	return seconds_since(start);
+}
+
+
+int main(int argc, char **argv) {
+	int threads = (argc > 1) ? std::atoi(argv[1]) : 1;
+	int repetitions = (argc > 2) ? std::atoi(argv[2]) : 3;
+
+	double seconds[4] = {0, 0, 0, 0};
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::vector<std::thread> workers;
+	std::vector<double> thread_seconds (4*threads, 1e300);
+	for (int t=0; t<threads; t++) {
+		workers.push_back(std::thread([t, repetitions, &thread_seconds]() {
+			double * best = &thread_seconds[4*t];
+			for (int r=0; r<repetitions; r++) {
+				best[0] = std::min(best[0], map_workload(t + 1));
+				best[1] = std::min(best[1], string_workload(t + 1));
+				best[2] = std::min(best[2], list_workload());
+				best[3] = std::min(best[3], array_workload(t + 1));
+			}
+		}));
+	}
+	for (int t=0; t<threads; t++) { workers[t].join(); }
+	double total = seconds_since(start);
+	for (int t=0; t<threads; t++) {
+		for (int w=0; w<4; w++) { seconds[w] += thread_seconds[4*t + w]/threads; }
+	}
+
+	std::cout << argv[0] << ", " << threads << " threads: map " << seconds[0] << " s, strings " << seconds[1] << " s, list "
+		<< seconds[2] << " s, arrays " << seconds[3] << " s, total " << total << " s" << std::endl;
+	return 0;
+}
@@ -0,0 +1,85 @@
+#include "weighting.hpp"
+
+#include <algorithm>
+
+
+static const int target = 1000;
+
+
+weighting_rule weighting_rule_for(int value) {
+	if (value < target/10.) { return weighting_rule::times_two; }
+	else if (value < target/4.) { return weighting_rule::times_four; }
+	else if (value < target/2.) { return weighting_rule::half; }
+	else if (value < 2.*target/3.) { return weighting_rule::quarter; }
+	else if (value < 9.*target/10.) { return weighting_rule::third; }
+	else { return weighting_rule::none; }
+}
+
+
+std::function<int(int)> function_builder(int value) {
+	switch (weighting_rule_for(value)) {
+		case weighting_rule::times_two: return [](int x) { return x*2; };
+		case weighting_rule::times_four: return [](int x) { return x*4; };
+		case weighting_rule::half: return [](int x) { return x/2; };
+		case weighting_rule::quarter: return [](int x) { return x/4; };
+		case weighting_rule::third: return [](int x) { return x/3; };
+		default: return nullptr;
+	}
+}
+
+
+// the kernels of the rules (multiplications wrap around like the lambdas do in practice, without signed overflow)
+template <int factor>
+class multiply {
+	public:
+		int operator() (int x) const { return (int) ((unsigned) x*factor); }
+};
+
+template <int divisor>
+class divide {
+	public:
+		int operator() (int x) const { return x/divisor; }
+};
+
+
+weighted_reduction::weighted_reduction (std::uint64_t seed) : seed(seed), lanes(seed) {}
+
+
+template <class weighting>
+std::int64_t weighted_reduction::weighted_sum(std::size_t count, weighting weight) {
+	/*
+	 * Generation, weighting and summation per chunk of the stack buffer, the values of a group of lanes beyond count are
+	 * dropped. Chunks end at the block boundaries of bulk_random_fill (the chunk size divides the block size).
+	 */
+	const std::size_t chunk = 512;
+	std::uint64_t bits[chunk];
+	std::int64_t sum = 0;
+
+	for (std::size_t first=0, n; first<count; first+=n) {
+		if (block_used == bulk_random_block) {
+			lanes = xoshiro256_lanes(seed, ++block);
+			block_used = 0;
+		}
+		n = std::min(std::min(chunk, count - first), bulk_random_block - block_used);
+		block_used += (n + bulk_random_lanes - 1)/bulk_random_lanes*bulk_random_lanes;
+		lanes.fill(bits, (n + bulk_random_lanes - 1)/bulk_random_lanes);
+		for (std::size_t i=0; i<n; i++) { sum += weight((int) (bits[i] >> 32)); }
+	}
+	return sum;
+}
+
+
+double weighted_reduction::mean(weighting_rule rule, std::size_t count) {
+	// one dispatch per call, the loops are specialized for the rule
+	std::int64_t sum;
+	switch (rule) {
+		case weighting_rule::times_two: sum = weighted_sum(count, multiply<2>()); break;
+		case weighting_rule::times_four: sum = weighted_sum(count, multiply<4>()); break;
+		case weighting_rule::half: sum = weighted_sum(count, divide<2>()); break;
+		case weighting_rule::quarter: sum = weighted_sum(count, divide<4>()); break;
+		case weighting_rule::third: sum = weighted_sum(count, divide<3>()); break;
+		default: throw std::bad_function_call();
+	}
+	return (double) sum/count;
+}
+
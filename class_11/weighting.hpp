@@ -0,0 +1,54 @@
+/* FILE WEIGHTING.HPP */
+#ifndef FILE_WEIGHTING_HPP
+#define FILE_WEIGHTING_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "bulk_random.hpp"
+
+/*
+ * The weighting rules of leak_simple.cpp and a fused reduction over them.
+ *
+ * weighting_rule_for(value) is the choice of function_builder (which returns it as a std::function, nullptr for none).
+ *
+ * weighted_reduction computes the mean of count weighted random values like leak_or_no_leak, without an array and without
+ * calling through std::function: the rule is resolved once per call by a switch to a kernel which is compiled for that rule,
+ * the random numbers are generated in chunks of 512 on the stack (the interleaved xoshiro256** lanes of bulk_random.hpp),
+ * then weighted and summed while the chunk is in L1. The loops vectorize, nothing is allocated on the heap.
+ * The sum is exact (64 bit integers), the values are the upper 32 bits of the random words as int, like in leak_or_no_leak.
+ * The rule none throws std::bad_function_call, as calling the empty std::function would.
+ *
+ * A weighted_reduction is a random stream: consecutive calls use consecutive random numbers (a partly used group of lanes
+ * is dropped at the end of a call). Like the fills it switches to the lanes of the next block every bulk_random_block
+ * values, so the first call of a fresh weighted_reduction(seed) uses the values of fill_random_bits(.., seed) and
+ * returns exactly the mean of leak_or_no_leak with these values.
+ */
+
+enum class weighting_rule { times_two, times_four, half, quarter, third, none };
+
+weighting_rule weighting_rule_for(int value);
+
+std::function<int(int)> function_builder(int value);
+
+
+class weighted_reduction {
+	public:
+		explicit weighted_reduction (std::uint64_t seed);
+
+		double mean(int count) { return mean(weighting_rule_for(count), count); }
+		double mean(weighting_rule rule, std::size_t count);
+
+	private:
+		std::uint64_t seed;
+		std::uint64_t block = 0;
+		std::size_t block_used = 0;	// values taken from the lanes of the current block
+		xoshiro256_lanes lanes;
+
+		template <class weighting>
+		std::int64_t weighted_sum(std::size_t count, weighting weight);
+};
+
+
+#endif /* FILE_WEIGHTING_HPP */
@@ -0,0 +1,116 @@
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+#include "bulk_random.hpp"
+#include "weighting.hpp"
+
+/*
+ * Throughput of the weighted mean of leak_simple.cpp: the array and std::function version (leak_or_no_leak, here with
+ * delete[] instead of the leak) against weighted_reduction.
+ *
+ *	mean_sum     runs calls with random counts below 900, like mean_sum of leak_simple.cpp
+ *	every rule   one call with count values per weighting rule
+ *
+ * Both versions seed every call alike (fill_random_bits with the seed of the call against a fresh
+ * weighted_reduction(seed)), so they use the same random values, pay the same setup per call and must return exactly the
+ * same results, which is checked.
+ *
+ * Usage: ./weighting_benchmark.out [runs [count]]   (default 10^5 runs, 10^7 values)
+ */
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+static double array_mean(int count, std::function<int(int)> weighter, std::uint64_t seed) {
+	int * values = new int[count];
+
+	std::vector<std::uint32_t> random_values (count);
+	fill_random_bits(random_values.data(), count, seed);
+
+	for (int i=0; i<count; i++) {
+		values[i] = weighter(random_values[i]);
+	}
+
+	double result = 0;
+	for (int i=0; i<count; i++) {
+		result += values[i];
+	}
+
+	delete[] values;
+	return result/count;
+}
+
+
+static void report(const char * name, double seconds, double values, double result) {
+	std::cout << "\t" << name << ": " << seconds << " s (" << values/seconds*1e-6 << " million values/s), result " << result
+		<< std::endl;
+}
+
+
+static void check(double array_result, double reduction_result) {
+	if (array_result != reduction_result) {
+		std::cout << "\tdifferent results: " << array_result << " and " << reduction_result << std::endl;
+		std::exit(1);
+	}
+}
+
+
+int main(int argc, char **argv) {
+	int runs = (argc > 1) ? std::atoi(argv[1]) : 100000;
+	int count = (argc > 2) ? std::atoi(argv[2]) : 10000000;
+
+	std::cout << "mean_sum, " << runs << " runs:" << std::endl;
+	{
+		// the counts and seeds of mean_sum (runs with count 0 have no mean and are skipped)
+		xoshiro256 rnd (1);
+		std::vector<int> counts (runs);
+		std::vector<std::uint64_t> seeds (runs);
+		double values = 0;
+		for (int i=0; i<runs; i++) {
+			counts[i] = 900.*rnd.uniform();
+			seeds[i] = rnd();
+			values += counts[i];
+		}
+
+		double array_total = 0;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int i=0; i<runs; i++) {
+			if (counts[i] > 0) { array_total += array_mean(counts[i], function_builder(counts[i]), seeds[i]); }
+		}
+		report("std::function and array", seconds_since(start), values, array_total);
+
+		double total = 0;
+		start = std::chrono::steady_clock::now();
+		for (int i=0; i<runs; i++) {
+			if (counts[i] > 0) { total += weighted_reduction(seeds[i]).mean(counts[i]); }
+		}
+		report("weighted_reduction", seconds_since(start), values, total);
+		check(array_total, total);
+	}
+
+	// a value for which function_builder chooses the rule
+	const char * names[] = { "x*2", "x*4", "x/2", "x/4", "x/3" };
+	const int rule_values[] = { 0, 100, 250, 500, 700 };
+	const weighting_rule rules[] = { weighting_rule::times_two, weighting_rule::times_four, weighting_rule::half,
+		weighting_rule::quarter, weighting_rule::third };
+
+	for (int r=0; r<5; r++) {
+		std::cout << names[r] << ", " << count << " values:" << std::endl;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		double array_result = array_mean(count, function_builder(rule_values[r]), 2);
+		report("std::function and array", seconds_since(start), count, array_result);
+
+		start = std::chrono::steady_clock::now();
+		double result = weighted_reduction(2).mean(rules[r], count);
+		report("weighted_reduction", seconds_since(start), count, result);
+		check(array_result, result);
+	}
+
+	return 0;
+}
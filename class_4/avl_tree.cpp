@@ -0,0 +1,397 @@
+#include "avl_tree.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <omp.h>
+
+
+void avl_tree::update(std::uint32_t index) {
+	/*
+	 * Recalculates height and subtree size of index from its children.
+	 */
+	avl_node & target = nodes[index];
+	target.height = 1 + std::max(node_height(target.left), node_height(target.right));
+	target.size = 1 + node_size(target.left) + node_size(target.right);
+}
+
+
+std::uint32_t avl_tree::rotate_left(std::uint32_t index) {
+	/*
+	 * The right child becomes the root of the subtree, returns its index.
+	 */
+	std::uint32_t pivot = nodes[index].right;
+	nodes[index].right = nodes[pivot].left;
+	nodes[pivot].left = index;
+	update(index);
+	update(pivot);
+	return pivot;
+}
+
+
+std::uint32_t avl_tree::rotate_right(std::uint32_t index) {
+	std::uint32_t pivot = nodes[index].left;
+	nodes[index].left = nodes[pivot].right;
+	nodes[pivot].right = index;
+	update(index);
+	update(pivot);
+	return pivot;
+}
+
+
+std::uint32_t avl_tree::rebalance(std::uint32_t index) {
+	/*
+	 * Restores the AVL condition at index (the subtrees are balanced already), returns the new root of the subtree.
+	 */
+	update(index);
+	int balance = node_height(nodes[index].left) - node_height(nodes[index].right);
+
+	if (balance > 1) {
+		// left-right case: rotate the left child first
+		if (node_height(nodes[nodes[index].left].left) < node_height(nodes[nodes[index].left].right)) {
+			nodes[index].left = rotate_left(nodes[index].left);
+		}
+		return rotate_right(index);
+	}
+	if (balance < -1) {
+		if (node_height(nodes[nodes[index].right].right) < node_height(nodes[nodes[index].right].left)) {
+			nodes[index].right = rotate_right(nodes[index].right);
+		}
+		return rotate_left(index);
+	}
+	return index;
+}
+
+
+void avl_tree::relink(std::uint32_t parent, std::uint32_t old_child, std::uint32_t new_child) {
+	/*
+	 * Replaces the child old_child of parent (the root if parent is none) by new_child.
+	 */
+	if (parent == none) { root_index = new_child; }
+	else if (nodes[parent].left == old_child) { nodes[parent].left = new_child; }
+	else { nodes[parent].right = new_child; }
+}
+
+
+int avl_tree::insert(int value) {
+	/*
+	 * Iterative insertion: descend to the new leaf and remember the path, then update heights and sizes and rotate
+	 * on the way back up. The path is at most 1.44 log2(2^32) < 64 nodes long.
+	 */
+	if (nodes.size() >= none) { throw std::length_error("avl_tree: too many nodes for 32-bit indices"); }
+
+	std::uint32_t path[64];
+	int depth = 0;
+
+	std::uint32_t current = root_index;
+	while (current != none) {
+		if (value == nodes[current].key) { return 1; }
+		path[depth++] = current;
+		current = (value < nodes[current].key) ? nodes[current].left : nodes[current].right;
+	}
+
+	avl_node leaf;
+	leaf.key = value;
+	leaf.left = none;
+	leaf.right = none;
+	leaf.height = 1;
+	leaf.size = 1;
+	nodes.push_back(leaf);
+	std::uint32_t child = nodes.size() - 1;
+
+	while (depth > 0) {
+		std::uint32_t parent = path[--depth];
+		if (value < nodes[parent].key) { nodes[parent].left = child; }
+		else { nodes[parent].right = child; }
+
+		// no rotations are necessary further up once the height of a subtree stays the same, only the sizes grow
+		int previous_height = nodes[parent].height;
+		child = rebalance(parent);
+		if (child == parent && nodes[parent].height == previous_height) {
+			while (depth > 0) { nodes[path[--depth]].size++; }
+			return 0;
+		}
+	}
+
+	root_index = child;
+	return 0;
+}
+
+
+int avl_tree::erase(int value) {
+	/*
+	 * Iterative deletion: a node with two children takes the key of its successor (the minimum of the right subtree),
+	 * which is removed instead. The heights and sizes are updated and the nodes rebalanced along the path back up.
+	 * Finally the last node of the arena is moved into the freed slot.
+	 */
+	std::uint32_t path[64];
+	int depth = 0;
+
+	std::uint32_t current = root_index;
+	while (current != none && nodes[current].key != value) {
+		path[depth++] = current;
+		current = (value < nodes[current].key) ? nodes[current].left : nodes[current].right;
+	}
+	if (current == none) { return 1; }
+
+	std::uint32_t removed = current;
+	if (nodes[current].left != none && nodes[current].right != none) {
+		path[depth++] = current;
+		removed = nodes[current].right;
+		while (nodes[removed].left != none) {
+			path[depth++] = removed;
+			removed = nodes[removed].left;
+		}
+		nodes[current].key = nodes[removed].key;
+	}
+
+	// the removed node has at most one child, which takes its place
+	std::uint32_t child = (nodes[removed].left != none) ? nodes[removed].left : nodes[removed].right;
+	relink((depth > 0) ? path[depth-1] : none, removed, child);
+
+	while (depth > 0) {
+		std::uint32_t parent = path[--depth];
+		std::uint32_t balanced = rebalance(parent);
+		relink((depth > 0) ? path[depth-1] : none, parent, balanced);
+	}
+
+	// keep the arena dense: move the last node into the slot of the removed one
+	std::uint32_t last = nodes.size() - 1;
+	if (removed != last) {
+		std::uint32_t parent = none;
+		current = root_index;
+		while (current != last) {
+			parent = current;
+			current = (nodes[last].key < nodes[current].key) ? nodes[current].left : nodes[current].right;
+		}
+		relink(parent, last, removed);
+		nodes[removed] = nodes[last];
+	}
+	nodes.pop_back();
+
+	return 0;
+}
+
+
+static void parallel_sort(std::vector<int> & keys) {
+	/*
+	 * Every thread sorts one chunk, then neighbouring chunks are merged pairwise in rounds
+	 * (the merges of one round are independent).
+	 */
+	std::size_t n = keys.size();
+	int chunks = omp_get_max_threads();
+	if (n < (1 << 16) || chunks == 1) {
+		std::sort(keys.begin(), keys.end());
+		return;
+	}
+
+	std::vector<std::size_t> bounds (chunks + 1);
+	for (int c=0; c<=chunks; c++) { bounds[c] = n*c/chunks; }
+
+	#pragma omp parallel for schedule(static, 1)
+	for (int c=0; c<chunks; c++) { std::sort(keys.begin() + bounds[c], keys.begin() + bounds[c+1]); }
+
+	for (int width=1; width<chunks; width*=2) {
+		#pragma omp parallel for schedule(dynamic, 1)
+		for (int c=0; c<chunks; c+=2*width) {
+			if (c + width < chunks) {
+				int end = std::min(c + 2*width, chunks);
+				std::inplace_merge(keys.begin() + bounds[c], keys.begin() + bounds[c+width], keys.begin() + bounds[end]);
+			}
+		}
+	}
+}
+
+
+static std::size_t remove_duplicates(std::vector<int> & sorted_keys, std::vector<int> * duplicates) {
+	// like std::unique, but counts (and collects) the removed keys
+	if (sorted_keys.empty()) { return 0; }
+
+	std::size_t kept = 1;
+	for (std::size_t i=1; i<sorted_keys.size(); i++) {
+		if (sorted_keys[i] != sorted_keys[kept-1]) { sorted_keys[kept++] = sorted_keys[i]; }
+		else if (duplicates != nullptr) { duplicates->push_back(sorted_keys[i]); }
+	}
+
+	std::size_t removed = sorted_keys.size() - kept;
+	sorted_keys.resize(kept);
+	return removed;
+}
+
+
+void avl_tree::build_sorted(const std::vector<int> & sorted_keys) {
+	/*
+	 * The subtree of the key range [low, high) has the middle key as root and the halves as children, so its size is
+	 * high - low and its height the bit length of the size. The node of the key i is stored at index i.
+	 * The top levels are built serially until the ranges are small enough, the remaining ranges are independent.
+	 */
+	std::size_t n = sorted_keys.size();
+	if (n >= none) { throw std::length_error("avl_tree: too many nodes for 32-bit indices"); }
+
+	// release the old nodes first, the new ones need as much memory
+	std::vector<avl_node>().swap(nodes);
+	nodes.resize(n);
+	root_index = (n == 0) ? none : n/2;
+
+	class key_range {
+		public:
+			std::uint32_t low, high;
+	};
+
+	auto build_node = [&](key_range range, key_range & left, key_range & right) {
+		std::uint32_t middle = range.low + (range.high - range.low)/2;
+		left.low = range.low;
+		left.high = middle;
+		right.low = middle + 1;
+		right.high = range.high;
+
+		avl_node & target = nodes[middle];
+		target.key = sorted_keys[middle];
+		target.left = (left.low < left.high) ? left.low + (left.high - left.low)/2 : none;
+		target.right = (right.low < right.high) ? right.low + (right.high - right.low)/2 : none;
+		target.size = range.high - range.low;
+		target.height = 64 - __builtin_clzll(target.size);
+	};
+
+	std::size_t grain = std::max<std::size_t>(n/(16*omp_get_max_threads()), 4096);
+	std::vector<key_range> pending, independent;
+	if (n > 0) { pending.push_back({0, (std::uint32_t) n}); }
+
+	while (!pending.empty()) {
+		key_range range = pending.back();
+		pending.pop_back();
+		if (range.high - range.low <= grain) {
+			independent.push_back(range);
+			continue;
+		}
+
+		key_range left, right;
+		build_node(range, left, right);
+		if (left.low < left.high) { pending.push_back(left); }
+		if (right.low < right.high) { pending.push_back(right); }
+	}
+
+	#pragma omp parallel for schedule(dynamic, 1)
+	for (std::size_t r=0; r<independent.size(); r++) {
+		std::vector<key_range> stack (1, independent[r]);
+		while (!stack.empty()) {
+			key_range range = stack.back();
+			stack.pop_back();
+
+			key_range left, right;
+			build_node(range, left, right);
+			if (left.low < left.high) { stack.push_back(left); }
+			if (right.low < right.high) { stack.push_back(right); }
+		}
+	}
+}
+
+
+std::size_t avl_tree::build(std::vector<int> keys, std::vector<int> * duplicates) {
+	parallel_sort(keys);
+	std::size_t removed = remove_duplicates(keys, duplicates);
+	build_sorted(keys);
+	return removed;
+}
+
+
+std::size_t avl_tree::insert_batch(std::vector<int> batch, std::vector<int> * duplicates) {
+	/*
+	 * Sorts the batch and merges it with the in-order keys of the tree in one pass, then rebuilds the tree.
+	 * Rebuilding costs O(n), so batches much smaller than the tree are inserted one by one (O(log n) each).
+	 */
+	parallel_sort(batch);
+	std::size_t removed = remove_duplicates(batch, duplicates);
+
+	if (batch.size()*64 < size()) {
+		for (std::size_t i=0; i<batch.size(); i++) {
+			if (insert(batch[i]) == 1) {
+				removed++;
+				if (duplicates != nullptr) { duplicates->push_back(batch[i]); }
+			}
+		}
+		return removed;
+	}
+
+	std::vector<int> merged;
+	merged.reserve(size() + batch.size());
+	std::size_t next = 0;
+
+	in_order([&](int key) {
+		while (next < batch.size() && batch[next] < key) { merged.push_back(batch[next++]); }
+		if (next < batch.size() && batch[next] == key) {
+			removed++;
+			if (duplicates != nullptr) { duplicates->push_back(key); }
+			next++;
+		}
+		merged.push_back(key);
+	});
+	merged.insert(merged.end(), batch.begin() + next, batch.end());
+
+	build_sorted(merged);
+	return removed;
+}
+
+
+std::uint32_t avl_tree::find(int value) const {
+	std::uint32_t current = root_index;
+	while (current != none) {
+		const avl_node & candidate = nodes[current];
+		if (value == candidate.key) { return current; }
+		current = (value < candidate.key) ? candidate.left : candidate.right;
+	}
+	return none;
+}
+
+
+std::size_t avl_tree::rank(int value) const {
+	/*
+	 * Every step to the right skips the left subtree and the node itself.
+	 */
+	std::size_t result = 0;
+	std::uint32_t current = root_index;
+	while (current != none) {
+		if (nodes[current].key < value) {
+			result += node_size(nodes[current].left) + 1;
+			current = nodes[current].right;
+		}
+		else { current = nodes[current].left; }
+	}
+	return result;
+}
+
+
+std::size_t avl_tree::count_less_equal(int value) const {
+	std::size_t result = 0;
+	std::uint32_t current = root_index;
+	while (current != none) {
+		if (nodes[current].key <= value) {
+			result += node_size(nodes[current].left) + 1;
+			current = nodes[current].right;
+		}
+		else { current = nodes[current].left; }
+	}
+	return result;
+}
+
+
+int avl_tree::select(std::size_t k) const {
+	if (k >= size()) { throw std::out_of_range("avl_tree::select: k is not smaller than the number of keys"); }
+
+	std::uint32_t current = root_index;
+	while (true) {
+		std::size_t left_size = node_size(nodes[current].left);
+		if (k < left_size) { current = nodes[current].left; }
+		else if (k == left_size) { return nodes[current].key; }
+		else {
+			k -= left_size + 1;
+			current = nodes[current].right;
+		}
+	}
+}
+
+
+std::size_t avl_tree::range_count(int low, int high) const {
+	if (high < low) { return 0; }
+	return count_less_equal(high) - rank(low);
+}
@@ -0,0 +1,105 @@
+/* FILE AVL_TREE.HPP */
+#ifndef FILE_AVL_TREE_HPP
+#define FILE_AVL_TREE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Self-balancing (AVL) binary search tree of ints with all nodes in one contiguous arena.
+ *
+ * Compared to the pointer tree of binary_tree.hpp:
+ *	- the heights of the two subtrees of every node differ by at most one, so the depth is at most 1.44 log2(n)
+ *	  for any insertion order (sorted input does not degenerate into a list)
+ *	- the nodes are stored in a std::vector and refer to each other with 32-bit indices (20 bytes per node instead of
+ *	  24 bytes plus the allocator overhead of every new), nodes inserted after each other are adjacent in memory
+ *	- clear() releases all nodes at once
+ *	- all operations are iterative, there is no recursion on deep trees
+ *
+ * Every node also stores the size of its subtree, so that order statistics take O(log n):
+ *	rank(value):           number of keys < value
+ *	select(k):             k-th smallest key (k = 0 is the minimum)
+ *	range_count(low, high): number of keys in [low, high]
+ *
+ * build and insert_batch load many keys at once: the keys are sorted (in parallel with OpenMP for large inputs) and the
+ * tree is constructed level-balanced in O(n), every subtree is the middle of its range. The node of the i-th smallest key is
+ * stored at index i, so in-order walks over a freshly built tree are sequential in memory. insert_batch merges the sorted
+ * batch with the keys of the tree in one pass and rebuilds (single inserts for batches much smaller than the tree).
+ * Both return the number of keys which were dropped as duplicates and optionally collect them.
+ *
+ * insert returns 0 if the value was inserted and 1 if it is already present (like insert_into_tree),
+ * erase returns 0 if the value was removed and 1 if it was not present. erase moves the last node of the arena into the
+ * freed slot, so the arena stays dense (node indices are not stable across erase).
+ */
+
+class avl_node {
+	public:
+		int key;
+		std::uint32_t left, right;
+		std::int32_t height;
+		std::uint32_t size;
+};
+
+
+class avl_tree {
+	public:
+		// index of a missing child
+		static const std::uint32_t none = 0xffffffffu;
+
+		int insert(int value);
+		int erase(int value);
+
+		// replaces the content with keys (in any order)
+		std::size_t build(std::vector<int> keys, std::vector<int> * duplicates = nullptr);
+		std::size_t insert_batch(std::vector<int> batch, std::vector<int> * duplicates = nullptr);
+		bool contains(int value) const { return find(value) != none; }
+
+		// index of the node with the given key (or none)
+		std::uint32_t find(int value) const;
+
+		std::size_t size() const { return node_size(root_index); }
+
+		std::size_t rank(int value) const;
+		int select(std::size_t k) const;
+		std::size_t range_count(int low, int high) const;
+
+		int height() const { return (root_index == none) ? 0 : nodes[root_index].height; }
+
+		void reserve(std::size_t count) { nodes.reserve(count); }
+		void clear() { std::vector<avl_node>().swap(nodes); root_index = none; }
+
+		std::uint32_t root() const { return root_index; }
+		const avl_node & node(std::uint32_t index) const { return nodes[index]; }
+
+		// calls function(key) for all keys in ascending order (iterative)
+		template <class callable>
+		void in_order(callable function) const {
+			std::uint32_t stack[128];
+			int depth = 0;
+			std::uint32_t current = root_index;
+
+			while (current != none || depth > 0) {
+				while (current != none) { stack[depth++] = current; current = nodes[current].left; }
+				current = stack[--depth];
+				function(nodes[current].key);
+				current = nodes[current].right;
+			}
+		}
+
+	private:
+		std::vector<avl_node> nodes;
+		std::uint32_t root_index = none;
+
+		int node_height(std::uint32_t index) const { return (index == none) ? 0 : nodes[index].height; }
+		std::size_t node_size(std::uint32_t index) const { return (index == none) ? 0 : nodes[index].size; }
+		void update(std::uint32_t index);
+		void relink(std::uint32_t parent, std::uint32_t old_child, std::uint32_t new_child);
+		std::size_t count_less_equal(int value) const;
+		void build_sorted(const std::vector<int> & sorted_keys);
+		std::uint32_t rotate_left(std::uint32_t index);
+		std::uint32_t rotate_right(std::uint32_t index);
+		std::uint32_t rebalance(std::uint32_t index);
+};
+
+#endif /* FILE_AVL_TREE_HPP */
@@ -1,8 +1,108 @@
 #include "binary_tree.hpp"
 
+#include <iostream>
+#include <vector>
+
 
 binary_tree_node::binary_tree_node (int value) {
 	node_data = value;
 	left = nullptr;
 	right = nullptr;
 }
+
+
+int insert_into_tree(binary_tree_node * root_node, int new_value) {
+
+	//std::cout << "inserting number " << new_value << std::endl;
+
+	// no tree is present -> create the first node
+	if (root_node == nullptr) {
+
+		std::cout << "creating node" << std::endl;
+
+		root_node = new binary_tree_node;
+		root_node->node_data = new_value;
+		root_node->left = nullptr;
+		root_node->right = nullptr;
+		return 0;
+	}
+
+	// descend iteratively, a degenerate tree (sorted input) is as deep as it has nodes
+	binary_tree_node * current = root_node;
+	while (true) {
+		if (new_value == current->node_data) {
+			// value already present in tree -> error
+			return 1;
+		}
+
+		// insert on the left or right side
+		binary_tree_node * & child = (new_value < current->node_data) ? current->left : current->right;
+
+		// no node present, create a new one
+		if (child == nullptr) {
+			child = new binary_tree_node(new_value);
+			return 0;
+		}
+		current = child;
+	}
+}
+
+void print_tree(binary_tree_node * root_node) {
+	/*
+	 * Iterative pre-order traversal, prints the same as the recursive version:
+	 * a node is printed with its label, then its left and its right subtree are printed with "left " and "right ".
+	 */
+	struct pending_node {
+		binary_tree_node * node;
+		const char * label;
+	};
+	std::vector<pending_node> stack;
+	stack.push_back({root_node, ""});
+
+	while (!stack.empty()) {
+		pending_node current = stack.back();
+		stack.pop_back();
+
+		std::cout << current.label;
+		if (current.node != nullptr) {
+			std::cout << current.node->node_data << std::endl;
+			stack.push_back({current.node->right, "right "});
+			stack.push_back({current.node->left, "left "});
+		}
+		else {
+			std::cout << "empty" << std::endl;
+		}
+	}
+}
+
+
+binary_tree_node * find_value_in_tree(binary_tree_node * root, int value_to_find) {
+
+	binary_tree_node * current = root;
+	while (current != nullptr) {
+		if (current->node_data == value_to_find) {
+			return current;
+		}
+		current = (value_to_find < current->node_data) ? current->left : current->right;
+	}
+
+	// value not found:
+	return nullptr;
+}
+
+int calc_nodes(binary_tree_node * root) {
+	/*
+	 * Iterative, visits every node (O(n)), see avl_tree::size() for O(1) counts.
+	 */
+	int count = 0;
+	std::vector<binary_tree_node *> pending;
+	if (root != nullptr) { pending.push_back(root); }
+	while (!pending.empty()) {
+		binary_tree_node * node = pending.back();
+		pending.pop_back();
+		count++;
+		if (node->left != nullptr) { pending.push_back(node->left); }
+		if (node->right != nullptr) { pending.push_back(node->right); }
+	}
+	return count;
+}
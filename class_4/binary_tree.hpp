@@ -1,3 +1,6 @@
+/* FILE BINARY_TREE.HPP */
+#ifndef FILE_BINARY_TREE_HPP
+#define FILE_BINARY_TREE_HPP
 
 
 class binary_tree_node {
@@ -9,3 +12,12 @@ class binary_tree_node {
 		binary_tree_node * left;
 		binary_tree_node * right;
 };
+
+
+// unbalanced binary search tree on binary_tree_node (returns 1 if the value is already present)
+int insert_into_tree(binary_tree_node * root_node, int new_value);
+void print_tree(binary_tree_node * root_node);
+binary_tree_node * find_value_in_tree(binary_tree_node * root, int value_to_find);
+int calc_nodes(binary_tree_node * root);
+
+#endif /* FILE_BINARY_TREE_HPP */
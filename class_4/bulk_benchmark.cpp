@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <omp.h>
+
+#include "avl_tree.hpp"
+
+/*
+ * Loading times of avl_tree: build from random keys, build from sorted keys and insert_batch, compared to single inserts.
+ *
+ * Usage: ./bulk_benchmark.out [count]   (default 10^8 keys, about 3 GB of memory)
+ *
+ * The keys are random values from [0, 2 count) (with duplicates), so count is at most 2^30 (the keys are int). The single
+ * inserts are only timed for min(count, 10^7) keys and extrapolated to count keys. The batch contains count/10 random
+ * keys from the same range, the ones which are already in the tree are counted as duplicates.
+ */
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+static std::vector<int> random_keys(std::size_t count, std::size_t range, unsigned seed) {
+	// keys from [0, range)
+	std::vector<int> keys (count);
+	std::mt19937 generator (seed);
+	std::uniform_int_distribution<int> distribution (0, range - 1);
+	for (std::size_t i=0; i<count; i++) { keys[i] = distribution(generator); }
+	return keys;
+}
+
+
+int main(int argc, char **argv) {
+	std::size_t count = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 100000000;
+	if (count == 0 || count > (std::size_t(1) << 30)) {
+		std::cerr << "count has to be in [1, 2^30] (the keys [0, 2 count) are int)" << std::endl;
+		return 1;
+	}
+	std::cout << "threads: " << omp_get_max_threads() << std::endl;
+
+	// single inserts as reference
+	{
+		std::size_t single_count = std::min<std::size_t>(count, 10000000);
+		std::vector<int> keys = random_keys(single_count, 2*count, 1);
+
+		avl_tree tree;
+		tree.reserve(single_count);
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (std::size_t i=0; i<single_count; i++) { tree.insert(keys[i]); }
+		double seconds = seconds_since(start);
+
+		std::cout << "single inserts: " << single_count << " keys in " << seconds << " s (" << seconds/single_count*1e9
+			<< " ns/key), about " << seconds/single_count*count << " s for " << count << " keys" << std::endl;
+	}
+
+	avl_tree tree;
+	{
+		std::vector<int> keys = random_keys(count, 2*count, 1);
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		std::size_t duplicates = tree.build(std::move(keys));
+		double seconds = seconds_since(start);
+
+		std::cout << "build (random): " << count << " keys in " << seconds << " s (" << seconds/count*1e9 << " ns/key), "
+			<< tree.size() << " distinct, " << duplicates << " duplicates, height " << tree.height() << std::endl;
+	}
+
+	{
+		std::vector<int> batch = random_keys(count/10, 2*count, 2);
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		std::size_t duplicates = tree.insert_batch(std::move(batch));
+		double seconds = seconds_since(start);
+
+		std::cout << "insert_batch: " << count/10 << " keys in " << seconds << " s, " << tree.size() << " keys in the tree, "
+			<< duplicates << " duplicates, height " << tree.height() << std::endl;
+	}
+
+	{
+		std::vector<int> keys (count);
+		for (std::size_t i=0; i<count; i++) { keys[i] = i; }
+		tree.clear();
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		tree.build(std::move(keys));
+		double seconds = seconds_since(start);
+
+		std::cout << "build (sorted): " << count << " keys in " << seconds << " s (" << seconds/count*1e9 << " ns/key), height "
+			<< tree.height() << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "concurrent_tree.hpp"
+
+/*
+ * Throughput of concurrent_tree for a mixed workload (80% lookups, 10% inserts, 10% erases of random keys)
+ * with 1, 2, 4, ..., 64 threads, compared to a std::set behind one std::mutex.
+ *
+ * Usage: ./concurrent_benchmark.out [keys] [operations]   (default 10^6 keys, 4*10^6 operations per run)
+ *
+ * The keys are drawn from [0, 2 keys) and the tree is filled with half of them, the inserts and erases keep the size
+ * roughly constant. The operations are split evenly between the threads, the time is measured from the common start
+ * until the last thread is done. With more threads than cores the numbers show the cost of oversubscription.
+ */
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+class xorshift {
+	// cheap per-thread random numbers, std::mt19937 would dominate the lookup time
+	public:
+		xorshift (std::uint64_t seed) : state(seed*0x9e3779b97f4a7c15ull + 1) {}
+
+		std::uint64_t operator() () {
+			state ^= state << 13;
+			state ^= state >> 7;
+			state ^= state << 17;
+			return state;
+		}
+
+	private:
+		std::uint64_t state;
+};
+
+
+template <class operation>
+static double run_threads(int thread_count, operation work) {
+	/*
+	 * Starts thread_count threads which wait for a common start signal and then call work(thread index).
+	 */
+	std::atomic<int> ready (0);
+	std::atomic<bool> start (false);
+	std::vector<std::thread> threads;
+
+	for (int t=0; t<thread_count; t++) {
+		threads.push_back(std::thread([&, t]() {
+			ready++;
+			while (!start.load()) { std::this_thread::yield(); }
+			work(t);
+		}));
+	}
+
+	while (ready.load() < thread_count) { std::this_thread::yield(); }
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	start.store(true);
+	for (int t=0; t<thread_count; t++) { threads[t].join(); }
+	return seconds_since(begin);
+}
+
+
+static void report(const std::string & name, std::size_t operations, double seconds, std::size_t size) {
+	std::cout << "\t" << std::setw(20) << std::left << name << std::right << std::setw(10) << operations/seconds*1e-6 << " Mops/s, "
+		<< seconds/operations*1e9 << " ns/op, final size " << size << std::endl;
+}
+
+
+int main(int argc, char **argv) {
+	std::size_t keys = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+	std::size_t operations = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 4000000;
+	std::uint64_t key_range = 2*keys;
+
+	std::cout << "hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+
+	// the same random half of the keys for both containers
+	std::vector<int> initial;
+	std::mt19937 generator (1);
+	for (std::size_t i=0; i<key_range; i++) {
+		if (generator() % 2 == 0) { initial.push_back(i); }
+	}
+	std::shuffle(initial.begin(), initial.end(), generator);
+
+	for (int thread_count=1; thread_count<=64; thread_count*=2) {
+		std::cout << thread_count << " threads:" << std::endl;
+		std::size_t per_thread = operations/thread_count;
+
+		{
+			concurrent_tree tree;
+			int main_thread = tree.register_thread();
+			for (std::size_t i=0; i<initial.size(); i++) { tree.insert(main_thread, initial[i], i); }
+
+			std::vector<int> thread_ids (thread_count);
+			for (int t=0; t<thread_count; t++) { thread_ids[t] = tree.register_thread(); }
+
+			std::atomic<std::size_t> found (0);
+			double seconds = run_threads(thread_count, [&](int t) {
+				xorshift random (t + 1);
+				std::size_t local_found = 0;
+				for (std::size_t i=0; i<per_thread; i++) {
+					std::uint64_t r = random();
+					int key = (r >> 8) % key_range;
+					int choice = r % 10;
+					if (choice == 0) { tree.insert(thread_ids[t], key, key); }
+					else if (choice == 1) { tree.erase(thread_ids[t], key); }
+					else { local_found += tree.contains(thread_ids[t], key); }
+				}
+				found += local_found;
+			});
+			report("concurrent_tree", per_thread*thread_count, seconds, tree.size());
+		}
+
+		{
+			std::set<int> tree (initial.begin(), initial.end());
+			std::mutex tree_mutex;
+
+			std::atomic<std::size_t> found (0);
+			double seconds = run_threads(thread_count, [&](int t) {
+				xorshift random (t + 1);
+				std::size_t local_found = 0;
+				for (std::size_t i=0; i<per_thread; i++) {
+					std::uint64_t r = random();
+					int key = (r >> 8) % key_range;
+					int choice = r % 10;
+					std::lock_guard<std::mutex> lock (tree_mutex);
+					if (choice == 0) { tree.insert(key); }
+					else if (choice == 1) { tree.erase(key); }
+					else { local_found += tree.count(key); }
+				}
+				found += local_found;
+			});
+			report("std::set + mutex", per_thread*thread_count, seconds, tree.size());
+		}
+	}
+
+	return 0;
+}
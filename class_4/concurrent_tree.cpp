@@ -0,0 +1,297 @@
+#include "concurrent_tree.hpp"
+
+#include <climits>
+#include <stdexcept>
+#include <thread>
+
+
+// bits of the version word
+static const std::uint64_t obsolete_bit = 1;
+static const std::uint64_t locked_bit = 2;
+
+// routing keys of the sentinel leaves, above all int keys
+static const std::int64_t sentinel_low = (std::int64_t) INT_MAX + 1;
+static const std::int64_t sentinel_high = (std::int64_t) INT_MAX + 2;
+
+
+concurrent_tree_node::concurrent_tree_node (std::int64_t key, int value, bool leaf) : version(0), key(key), value(value), leaf(leaf) {
+	left.store(nullptr, std::memory_order_relaxed);
+	right.store(nullptr, std::memory_order_relaxed);
+}
+
+
+static bool read_lock(const concurrent_tree_node * node, std::uint64_t & version) {
+	/*
+	 * Waits until the node is not locked and returns false if it was removed from the tree.
+	 */
+	version = node->version.load();
+	while (version & locked_bit) {
+		// the lock is only held for a few instructions, but the holder might be descheduled (more threads than cores)
+		std::this_thread::yield();
+		version = node->version.load();
+	}
+	return !(version & obsolete_bit);
+}
+
+
+static bool validate(const concurrent_tree_node * node, std::uint64_t version) {
+	return node->version.load() == version;
+}
+
+
+static bool upgrade_to_lock(concurrent_tree_node * node, std::uint64_t version) {
+	// fails if the node changed since version was read
+	return node->version.compare_exchange_strong(version, version + locked_bit);
+}
+
+
+static void unlock(concurrent_tree_node * node) {
+	// clears the locked bit, the carry increments the modification count
+	node->version.fetch_add(locked_bit);
+}
+
+
+static void unlock_obsolete(concurrent_tree_node * node) {
+	node->version.fetch_add(locked_bit + obsolete_bit);
+}
+
+
+static std::atomic<concurrent_tree_node *> & child_slot(concurrent_tree_node * node, std::int64_t key) {
+	return (key < node->key) ? node->left : node->right;
+}
+
+
+epoch_manager::epoch_manager() : global_epoch(1), thread_count(0) {
+	for (int t=0; t<max_threads; t++) { threads[t].epoch.store(0, std::memory_order_relaxed); }
+}
+
+
+epoch_manager::~epoch_manager() {
+	for (int t=0; t<max_threads; t++) {
+		for (std::size_t i=0; i<threads[t].retired.size(); i++) { delete threads[t].retired[i].node; }
+	}
+}
+
+
+int epoch_manager::register_thread() {
+	int thread = thread_count.fetch_add(1);
+	if (thread >= max_threads) { throw std::length_error("epoch_manager: too many threads"); }
+	return thread;
+}
+
+
+void epoch_manager::enter(int thread) {
+	/*
+	 * The announced epoch has to be the global one at some point after the announcement,
+	 * otherwise the global epoch could pass it before the other threads see it.
+	 */
+	std::uint64_t epoch;
+	do {
+		epoch = global_epoch.load();
+		threads[thread].epoch.store(epoch);
+	} while (global_epoch.load() != epoch);
+}
+
+
+void epoch_manager::exit(int thread) {
+	threads[thread].epoch.store(0, std::memory_order_release);
+}
+
+
+void epoch_manager::retire(int thread, concurrent_tree_node * node) {
+	retired_node entry;
+	entry.node = node;
+	entry.epoch = global_epoch.load();
+	threads[thread].retired.push_back(entry);
+
+	if (threads[thread].retired.size() % 64 == 0) {
+		try_advance();
+		reclaim(thread);
+	}
+}
+
+
+bool epoch_manager::try_advance() {
+	/*
+	 * The global epoch moves on once all threads inside an operation announced the current one.
+	 */
+	std::uint64_t epoch = global_epoch.load();
+	int registered = thread_count.load();
+	if (registered > max_threads) { registered = max_threads; }
+
+	for (int t=0; t<registered; t++) {
+		std::uint64_t announced = threads[t].epoch.load();
+		if (announced != 0 && announced != epoch) { return false; }
+	}
+	return global_epoch.compare_exchange_strong(epoch, epoch + 1);
+}
+
+
+void epoch_manager::reclaim(int thread) {
+	std::uint64_t epoch = global_epoch.load();
+	std::vector<retired_node> & retired = threads[thread].retired;
+
+	std::size_t kept = 0;
+	for (std::size_t i=0; i<retired.size(); i++) {
+		if (retired[i].epoch + 2 <= epoch) { delete retired[i].node; }
+		else { retired[kept++] = retired[i]; }
+	}
+	retired.resize(kept);
+}
+
+
+concurrent_tree::concurrent_tree() : count(0) {
+	root = new concurrent_tree_node(sentinel_high, 0, false);
+	root->left.store(new concurrent_tree_node(sentinel_low, 0, true));
+	root->right.store(new concurrent_tree_node(sentinel_high, 0, true));
+}
+
+
+concurrent_tree::~concurrent_tree() {
+	// iterative, the tree might be degenerate
+	std::vector<concurrent_tree_node *> pending;
+	pending.push_back(root);
+	while (!pending.empty()) {
+		concurrent_tree_node * node = pending.back();
+		pending.pop_back();
+		if (!node->leaf) {
+			pending.push_back(node->left.load(std::memory_order_relaxed));
+			pending.push_back(node->right.load(std::memory_order_relaxed));
+		}
+		delete node;
+	}
+}
+
+
+bool concurrent_tree::search(int key, search_result & result) const {
+	/*
+	 * Optimistic descent to the leaf of key. The version of every node is read before its child pointer and validated after
+	 * the version of the child was read, so the child was reachable from the parent at that moment.
+	 * Returns false if the caller has to restart.
+	 */
+	result.grandparent = nullptr;
+	result.grandparent_version = 0;
+	result.parent = root;
+	if (!read_lock(root, result.parent_version)) { return false; }
+
+	concurrent_tree_node * node = child_slot(root, key).load();
+	while (true) {
+		std::uint64_t version;
+		if (!read_lock(node, version)) { return false; }
+		if (!validate(result.parent, result.parent_version)) { return false; }
+
+		if (node->leaf) {
+			result.leaf = node;
+			result.leaf_version = version;
+			return true;
+		}
+
+		result.grandparent = result.parent;
+		result.grandparent_version = result.parent_version;
+		result.parent = node;
+		result.parent_version = version;
+		node = child_slot(node, key).load();
+	}
+}
+
+
+bool concurrent_tree::find(int thread, int key, int & value) {
+	epochs.enter(thread);
+
+	search_result path;
+	while (!search(key, path)) {}
+
+	// the leaves do not change, only their version
+	bool found = (path.leaf->key == key);
+	if (found) { value = path.leaf->value; }
+
+	epochs.exit(thread);
+	return found;
+}
+
+
+int concurrent_tree::insert(int thread, int key, int value) {
+	/*
+	 * The leaf l of key is replaced by an inner node with the leaves l and (key, value) as children.
+	 */
+	epochs.enter(thread);
+
+	concurrent_tree_node * new_leaf = new concurrent_tree_node(key, value, true);
+	search_result path;
+
+	while (true) {
+		if (!search(key, path)) { continue; }
+
+		if (path.leaf->key == key) {
+			epochs.exit(thread);
+			delete new_leaf;
+			return 1;
+		}
+
+		// prepared before locking, the lock is only held for the pointer update
+		bool leaf_is_smaller = path.leaf->key < key;
+		concurrent_tree_node * inner = new concurrent_tree_node(leaf_is_smaller ? key : path.leaf->key, 0, false);
+		inner->left.store(leaf_is_smaller ? path.leaf : new_leaf, std::memory_order_relaxed);
+		inner->right.store(leaf_is_smaller ? new_leaf : path.leaf, std::memory_order_relaxed);
+
+		if (!upgrade_to_lock(path.parent, path.parent_version)) {
+			delete inner;
+			continue;
+		}
+
+		// the version did not change since the search, so the parent still points to the leaf
+		child_slot(path.parent, key).store(inner);
+		unlock(path.parent);
+		break;
+	}
+
+	count.fetch_add(1, std::memory_order_relaxed);
+	epochs.exit(thread);
+	return 0;
+}
+
+
+int concurrent_tree::erase(int thread, int key) {
+	/*
+	 * The parent of the leaf is replaced by the sibling of the leaf, parent and leaf are retired.
+	 * The locks are taken top-down by upgrading the versions of the search, a failed upgrade releases everything and restarts.
+	 */
+	epochs.enter(thread);
+
+	search_result path;
+	while (true) {
+		if (!search(key, path)) { continue; }
+
+		if (path.leaf->key != key) {
+			epochs.exit(thread);
+			return 1;
+		}
+
+		// real leaves always have a grandparent (the sentinels are never removed)
+		if (!upgrade_to_lock(path.grandparent, path.grandparent_version)) { continue; }
+		if (!upgrade_to_lock(path.parent, path.parent_version)) {
+			unlock(path.grandparent);
+			continue;
+		}
+		if (!upgrade_to_lock(path.leaf, path.leaf_version)) {
+			unlock(path.parent);
+			unlock(path.grandparent);
+			continue;
+		}
+
+		concurrent_tree_node * sibling = (key < path.parent->key) ? path.parent->right.load() : path.parent->left.load();
+		child_slot(path.grandparent, key).store(sibling);
+
+		unlock_obsolete(path.leaf);
+		unlock_obsolete(path.parent);
+		unlock(path.grandparent);
+		break;
+	}
+
+	epochs.retire(thread, path.leaf);
+	epochs.retire(thread, path.parent);
+
+	count.fetch_sub(1, std::memory_order_relaxed);
+	epochs.exit(thread);
+	return 0;
+}
@@ -0,0 +1,124 @@
+/* FILE CONCURRENT_TREE.HPP */
+#ifndef FILE_CONCURRENT_TREE_HPP
+#define FILE_CONCURRENT_TREE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Ordered map int -> int which can be shared between threads: concurrent inserts, erases and lookups.
+ *
+ * The tree is an unbalanced binary search tree like binary_tree.hpp, but leaf oriented: the key-value pairs are in the
+ * leaves, the inner nodes only route (go left if key < routing key). Two sentinel leaves above all int keys guarantee that
+ * every real leaf has a parent and a grandparent, an insert replaces a leaf by an inner node with two leaves (lock: parent),
+ * an erase replaces the parent of the leaf by the sibling of the leaf (locks: grandparent, parent, leaf).
+ *
+ * Synchronisation is optimistic lock coupling: every node has a version word (bit 0 obsolete, bit 1 locked, the rest counts
+ * the modifications). Readers never write shared memory, they remember the versions along the path and restart if a node
+ * changed before they moved on to its child. Writers upgrade the remembered version to a lock with a single CAS, so the
+ * locks are only taken at the place of the modification and only for a few instructions. find is therefore lock-free
+ * in practice, insert and erase do not block each other unless they modify the same nodes.
+ *
+ * Removed nodes might still be read by concurrent operations, they are freed by epoch-based reclamation (epoch_manager):
+ * a node retired in epoch e is deleted once the global epoch reached e + 2, i.e. after every thread left the operations
+ * which were running when it was removed.
+ *
+ * Every thread has to call register_thread() once and pass the returned id to all operations (at most max_threads).
+ * insert returns 0 if the key was inserted and 1 if it is already present (like insert_into_tree), erase returns 0 if the
+ * key was removed and 1 if it was not present. As with the pointer tree, sorted insertion orders degenerate into a list.
+ */
+
+class concurrent_tree_node {
+	public:
+		concurrent_tree_node (std::int64_t key, int value, bool leaf);
+
+		std::atomic<std::uint64_t> version;
+		const std::int64_t key;
+		const int value;
+		const bool leaf;
+		std::atomic<concurrent_tree_node *> left, right;
+};
+
+
+class epoch_manager {
+	public:
+		static const int max_threads = 128;
+
+		epoch_manager();
+		~epoch_manager();
+
+		epoch_manager (const epoch_manager &) = delete;
+		epoch_manager & operator = (const epoch_manager &) = delete;
+
+		int register_thread();
+
+		// every access to shared nodes has to be between enter and exit
+		void enter(int thread);
+		void exit(int thread);
+
+		// deletes the node once no thread can read it anymore
+		void retire(int thread, concurrent_tree_node * node);
+
+	private:
+		class retired_node {
+			public:
+				concurrent_tree_node * node;
+				std::uint64_t epoch;
+		};
+
+		// one cache line per thread, the epochs of other threads are only read when advancing the global epoch
+		class alignas(64) thread_state {
+			public:
+				// 0 while the thread is outside an operation
+				std::atomic<std::uint64_t> epoch;
+				std::vector<retired_node> retired;
+		};
+
+		alignas(64) std::atomic<std::uint64_t> global_epoch;
+		std::atomic<int> thread_count;
+		thread_state threads[max_threads];
+
+		bool try_advance();
+		void reclaim(int thread);
+};
+
+
+class concurrent_tree {
+	public:
+		static const int max_threads = epoch_manager::max_threads;
+
+		concurrent_tree();
+		~concurrent_tree();
+
+		concurrent_tree (const concurrent_tree &) = delete;
+		concurrent_tree & operator = (const concurrent_tree &) = delete;
+
+		int register_thread() { return epochs.register_thread(); }
+
+		int insert(int thread, int key, int value);
+		int erase(int thread, int key);
+
+		// value is only written if the key is found
+		bool find(int thread, int key, int & value);
+		bool contains(int thread, int key) { int value; return find(thread, key, value); }
+
+		// exact if no operation is running
+		std::size_t size() const { return count.load(std::memory_order_relaxed); }
+
+	private:
+		concurrent_tree_node * root;
+		std::atomic<std::size_t> count;
+		epoch_manager epochs;
+
+		class search_result {
+			public:
+				concurrent_tree_node * grandparent, * parent, * leaf;
+				std::uint64_t grandparent_version, parent_version, leaf_version;
+		};
+
+		bool search(int key, search_result & result) const;
+};
+
+#endif /* FILE_CONCURRENT_TREE_HPP */
@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "avl_tree.hpp"
+#include "binary_tree.hpp"
+#include "frozen_tree.hpp"
+
+/*
+ * Lookup times of the frozen (Eytzinger) tree compared to the pointer tree, std::set and avl_tree.
+ *
+ * Usage: ./freeze_benchmark.out [count]   (default 10^7 keys)
+ *
+ * The keys 0, 2, 4, ... are inserted in random order, the queries are count random values from [0, 2 count),
+ * so about half of them are found.
+ */
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+static void report(const std::string & name, std::size_t queries, double seconds, std::size_t found) {
+	std::cout << "\t" << name << ": " << seconds << " s (" << seconds/queries*1e9 << " ns/lookup), found " << found << std::endl;
+}
+
+
+int main(int argc, char **argv) {
+	std::size_t count = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+
+	std::vector<int> keys (count);
+	for (std::size_t i=0; i<count; i++) { keys[i] = 2*i; }
+	std::shuffle(keys.begin(), keys.end(), std::mt19937(1));
+
+	std::vector<int> queries (count);
+	std::mt19937 generator (2);
+	std::uniform_int_distribution<int> distribution (0, 2*count - 1);
+	for (std::size_t i=0; i<count; i++) { queries[i] = distribution(generator); }
+
+	std::cout << count << " keys, " << count << " lookups:" << std::endl;
+
+	// pointer tree
+	binary_tree_node * root = new binary_tree_node(keys[0]);
+	for (std::size_t i=1; i<count; i++) { insert_into_tree(root, keys[i]); }
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::size_t found = 0;
+	for (std::size_t i=0; i<count; i++) { found += (find_value_in_tree(root, queries[i]) != nullptr); }
+	report("pointer tree", count, seconds_since(start), found);
+
+	// frozen copy of the pointer tree (the pointer tree is not needed any more afterwards)
+	start = std::chrono::steady_clock::now();
+	frozen_tree frozen_pointer_tree (root);
+	double freeze_seconds = seconds_since(start);
+
+	std::vector<binary_tree_node *> pending (1, root);
+	while (!pending.empty()) {
+		binary_tree_node * node = pending.back();
+		pending.pop_back();
+		if (node->left != nullptr) { pending.push_back(node->left); }
+		if (node->right != nullptr) { pending.push_back(node->right); }
+		delete node;
+	}
+
+	start = std::chrono::steady_clock::now();
+	found = 0;
+	for (std::size_t i=0; i<count; i++) { found += frozen_pointer_tree.contains(queries[i]); }
+	report("frozen pointer tree (freeze " + std::to_string(freeze_seconds) + " s)", count, seconds_since(start), found);
+
+	// std::set
+	{
+		std::set<int> tree (keys.begin(), keys.end());
+
+		start = std::chrono::steady_clock::now();
+		found = 0;
+		for (std::size_t i=0; i<count; i++) { found += tree.count(queries[i]); }
+		report("std::set", count, seconds_since(start), found);
+	}
+
+	// avl_tree and its frozen copy
+	avl_tree tree;
+	tree.reserve(count);
+	for (std::size_t i=0; i<count; i++) { tree.insert(keys[i]); }
+
+	start = std::chrono::steady_clock::now();
+	found = 0;
+	for (std::size_t i=0; i<count; i++) { found += tree.contains(queries[i]); }
+	report("avl_tree", count, seconds_since(start), found);
+
+	start = std::chrono::steady_clock::now();
+	frozen_tree frozen (tree);
+	freeze_seconds = seconds_since(start);
+	tree.clear();
+
+	start = std::chrono::steady_clock::now();
+	found = 0;
+	for (std::size_t i=0; i<count; i++) { found += frozen.contains(queries[i]); }
+	report("frozen avl_tree (freeze " + std::to_string(freeze_seconds) + " s)", count, seconds_since(start), found);
+
+	std::vector<std::uint8_t> results (count);
+	start = std::chrono::steady_clock::now();
+	frozen.contains_batch(queries.data(), count, results.data());
+	double batch_seconds = seconds_since(start);
+	found = 0;
+	for (std::size_t i=0; i<count; i++) { found += results[i]; }
+	report("frozen avl_tree, contains_batch", count, batch_seconds, found);
+
+	return 0;
+}
@@ -0,0 +1,131 @@
+#include "frozen_tree.hpp"
+
+#include <climits>
+#include <cstdlib>
+#include <new>
+
+
+frozen_tree::frozen_tree (const avl_tree & tree) {
+	std::vector<int> sorted_keys;
+	sorted_keys.reserve(tree.size());
+	tree.in_order([&](int key) { sorted_keys.push_back(key); });
+	build(sorted_keys);
+}
+
+
+frozen_tree::frozen_tree (binary_tree_node * root) {
+	/*
+	 * Iterative in-order traversal of the pointer tree (it might be degenerate).
+	 */
+	std::vector<int> sorted_keys;
+	std::vector<binary_tree_node *> stack;
+	binary_tree_node * current = root;
+
+	while (current != nullptr || !stack.empty()) {
+		while (current != nullptr) { stack.push_back(current); current = current->left; }
+		current = stack.back();
+		stack.pop_back();
+		sorted_keys.push_back(current->node_data);
+		current = current->right;
+	}
+
+	build(sorted_keys);
+}
+
+
+frozen_tree::frozen_tree (const std::vector<int> & sorted_keys) {
+	build(sorted_keys);
+}
+
+
+frozen_tree::~frozen_tree() {
+	std::free(keys);
+}
+
+
+void frozen_tree::build(const std::vector<int> & sorted_keys) {
+	/*
+	 * Fills the complete tree of height h (2^h - 1 nodes) in-order with the keys followed by the INT_MAX padding.
+	 */
+	count = sorted_keys.size();
+	has_max_key = count > 0 && sorted_keys.back() == INT_MAX;
+
+	height = 0;
+	while (((std::size_t) 1 << height) - 1 < count) { height++; }
+	std::size_t nodes = ((std::size_t) 1 << height) - 1;
+
+	// index 0 is unused, the array is aligned to cache lines (prefetches beyond its end are harmless)
+	capacity = (nodes + 1 + 15)/16*16;
+	void * memory = nullptr;
+	if (posix_memalign(&memory, 64, capacity*sizeof(int)) != 0) { throw std::bad_alloc(); }
+	keys = static_cast<int *>(memory);
+	for (std::size_t k=0; k<capacity; k++) { keys[k] = INT_MAX; }
+
+	if (nodes == 0) { return; }
+
+	// iterative in-order walk over the implicit tree: start at the leftmost node, the successor of k is the leftmost node
+	// in the right subtree or (without right subtree) the parent of the first ancestor reached from a left child
+	std::size_t k = 1;
+	while (2*k <= nodes) { k = 2*k; }
+
+	for (std::size_t i=0; i<count; i++) {
+		keys[k] = sorted_keys[i];
+
+		if (2*k + 1 <= nodes) {
+			k = 2*k + 1;
+			while (2*k <= nodes) { k = 2*k; }
+		}
+		else {
+			while (k % 2 == 1) { k /= 2; }
+			k /= 2;
+		}
+	}
+}
+
+
+std::size_t frozen_tree::lower_bound(int value) const {
+	/*
+	 * Index of the first key >= value in the in-order sequence (0 if there is none).
+	 * After h steps k encodes the path, the trailing ones are the steps to the right after the last step to the left.
+	 */
+	std::size_t k = 1;
+	for (int level=0; level<height; level++) {
+		__builtin_prefetch(keys + 16*k);
+		k = 2*k + (keys[k] < value);
+	}
+	return k >> __builtin_ffsll(~k);
+}
+
+
+bool frozen_tree::contains(int value) const {
+	// the padding must not be found
+	if (value == INT_MAX) { return has_max_key; }
+
+	std::size_t k = lower_bound(value);
+	return k != 0 && keys[k] == value;
+}
+
+
+void frozen_tree::contains_batch(const int * values, std::size_t n, std::uint8_t * found) const {
+	const int group = 16;
+	std::size_t k[group];
+
+	for (std::size_t first=0; first<n; first+=group) {
+		int size = (n - first < (std::size_t) group) ? n - first : group;
+
+		for (int q=0; q<size; q++) { k[q] = 1; }
+
+		for (int level=0; level<height; level++) {
+			for (int q=0; q<size; q++) {
+				__builtin_prefetch(keys + 16*k[q]);
+				k[q] = 2*k[q] + (keys[k[q]] < values[first + q]);
+			}
+		}
+
+		for (int q=0; q<size; q++) {
+			std::size_t index = k[q] >> __builtin_ffsll(~k[q]);
+			int value = values[first + q];
+			found[first + q] = (value == INT_MAX) ? has_max_key : (index != 0 && keys[index] == value);
+		}
+	}
+}
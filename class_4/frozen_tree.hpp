@@ -0,0 +1,52 @@
+/* FILE FROZEN_TREE.HPP */
+#ifndef FILE_FROZEN_TREE_HPP
+#define FILE_FROZEN_TREE_HPP
+
+#include "avl_tree.hpp"
+#include "binary_tree.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Read-only copy ("freeze") of a search tree in the implicit Eytzinger layout: the keys are stored in breadth first order in one
+ * cache line aligned array, the children of the node k are 2k and 2k+1 (k starts at 1). The array is padded to a complete tree
+ * of height h with INT_MAX, so that every search takes exactly h steps.
+ *
+ * A search needs no pointers and no branches, k = 2k + (key[k] < value), and the four levels below the current node share
+ * one cache line (16 ints at index 16k), which is prefetched ahead. contains_batch runs up to 16 searches in lockstep,
+ * so that the cache misses of independent searches overlap.
+ *
+ * A frozen tree does not change if the original tree is modified, freeze again after updates.
+ */
+class frozen_tree {
+	public:
+		frozen_tree (const avl_tree & tree);
+		frozen_tree (binary_tree_node * root);
+
+		// from keys in ascending order (no duplicates)
+		frozen_tree (const std::vector<int> & sorted_keys);
+
+		~frozen_tree();
+
+		frozen_tree (const frozen_tree &) = delete;
+		frozen_tree & operator = (const frozen_tree &) = delete;
+
+		std::size_t size() const { return count; }
+		bool contains(int value) const;
+
+		// found[i] = contains(values[i]) for i < n
+		void contains_batch(const int * values, std::size_t n, std::uint8_t * found) const;
+
+	private:
+		int * keys = nullptr;
+		std::size_t count = 0, capacity = 0;
+		int height = 0;
+		bool has_max_key = false;
+
+		void build(const std::vector<int> & sorted_keys);
+		std::size_t lower_bound(int value) const;
+};
+
+#endif /* FILE_FROZEN_TREE_HPP */
@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "avl_tree.hpp"
+#include "binary_tree.hpp"
+
+/*
+ * Insertion and lookup times of avl_tree, std::set and the pointer tree of binary_tree.hpp for sorted, reverse sorted and
+ * random insertion orders, and the rank and erase times of avl_tree.
+ *
+ * Usage: ./tree_benchmark.out [count]   (default 10^7 keys)
+ *
+ * The pointer tree degenerates into a list for sorted input (quadratic insertion time and recursion depth n),
+ * it is therefore only run with min(count, 10^4) keys in the sorted cases.
+ */
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+static void delete_tree(binary_tree_node * root) {
+	// iterative, the degenerate trees are too deep for recursion
+	std::vector<binary_tree_node *> pending;
+	if (root != nullptr) { pending.push_back(root); }
+	while (!pending.empty()) {
+		binary_tree_node * node = pending.back();
+		pending.pop_back();
+		if (node->left != nullptr) { pending.push_back(node->left); }
+		if (node->right != nullptr) { pending.push_back(node->right); }
+		delete node;
+	}
+}
+
+
+static void report(const std::string & name, std::size_t count, double insert_seconds, double lookup_seconds, std::size_t found) {
+	std::cout << "\t" << name << ": " << count << " keys, insert " << insert_seconds << " s (" << insert_seconds/count*1e9 << " ns/key), "
+		<< "lookup " << lookup_seconds << " s (" << lookup_seconds/count*1e9 << " ns/key), found " << found << std::endl;
+}
+
+
+static void run(const std::string & order, std::vector<int> keys, const std::vector<int> & queries, bool degenerate) {
+	std::cout << order << ":" << std::endl;
+
+	// arena AVL tree
+	{
+		avl_tree tree;
+		tree.reserve(keys.size());
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (std::size_t i=0; i<keys.size(); i++) { tree.insert(keys[i]); }
+		double insert_seconds = seconds_since(start);
+
+		start = std::chrono::steady_clock::now();
+		std::size_t found = 0;
+		for (std::size_t i=0; i<queries.size(); i++) { found += tree.contains(queries[i]); }
+		double lookup_seconds = seconds_since(start);
+
+		report("avl_tree (height " + std::to_string(tree.height()) + ")", keys.size(), insert_seconds, lookup_seconds, found);
+
+		// order statistics use the subtree sizes, O(log n) per query
+		start = std::chrono::steady_clock::now();
+		std::size_t rank_sum = 0;
+		for (std::size_t i=0; i<queries.size(); i++) { rank_sum += tree.rank(queries[i]); }
+		double rank_seconds = seconds_since(start);
+
+		start = std::chrono::steady_clock::now();
+		for (std::size_t i=0; i<queries.size(); i++) { tree.erase(queries[i]); }
+		double erase_seconds = seconds_since(start);
+
+		std::cout << "\t\trank " << rank_seconds/queries.size()*1e9 << " ns/key (sum " << rank_sum << "), erase "
+			<< erase_seconds/queries.size()*1e9 << " ns/key, " << tree.size() << " keys left" << std::endl;
+	}
+
+	// std::set (red-black tree, one allocation per node)
+	{
+		std::set<int> tree;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (std::size_t i=0; i<keys.size(); i++) { tree.insert(keys[i]); }
+		double insert_seconds = seconds_since(start);
+
+		start = std::chrono::steady_clock::now();
+		std::size_t found = 0;
+		for (std::size_t i=0; i<queries.size(); i++) { found += tree.count(queries[i]); }
+		double lookup_seconds = seconds_since(start);
+
+		report("std::set", keys.size(), insert_seconds, lookup_seconds, found);
+	}
+
+	// unbalanced pointer tree
+	{
+		std::size_t count = degenerate ? std::min<std::size_t>(keys.size(), 10000) : keys.size();
+		std::vector<int> subset (keys.begin(), keys.begin() + count);
+
+		binary_tree_node * root = new binary_tree_node(subset[0]);
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (std::size_t i=1; i<count; i++) { insert_into_tree(root, subset[i]); }
+		double insert_seconds = seconds_since(start);
+
+		std::shuffle(subset.begin(), subset.end(), std::mt19937(1));
+		start = std::chrono::steady_clock::now();
+		std::size_t found = 0;
+		for (std::size_t i=0; i<count; i++) { found += (find_value_in_tree(root, subset[i]) != nullptr); }
+		double lookup_seconds = seconds_since(start);
+
+		report("pointer tree", count, insert_seconds, lookup_seconds, found);
+		delete_tree(root);
+	}
+}
+
+
+int main(int argc, char **argv) {
+	std::size_t count = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+
+	std::vector<int> keys (count);
+	for (std::size_t i=0; i<count; i++) { keys[i] = i; }
+
+	// the lookups query all keys in random order
+	std::vector<int> queries = keys;
+	std::shuffle(queries.begin(), queries.end(), std::mt19937(2));
+
+	run("sorted", keys, queries, true);
+
+	std::reverse(keys.begin(), keys.end());
+	run("reverse sorted", keys, queries, true);
+
+	std::shuffle(keys.begin(), keys.end(), std::mt19937(3));
+	run("random", keys, queries, false);
+
+	return 0;
+}
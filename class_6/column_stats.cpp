@@ -0,0 +1,566 @@
+#include "column_stats.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <omp.h>
+
+#include "bulk_random.hpp"
+
+
+void column_statistics::add(double value) {
+	// Welford's update, stable also for values far from zero
+	count++;
+	double delta = value - mean;
+	mean += delta/count;
+	m2 += delta*(value - mean);
+	minimum = std::min(minimum, value);
+	maximum = std::max(maximum, value);
+}
+
+
+void column_statistics::merge(const column_statistics & other) {
+	/*
+	 * Combination of two partial results (Chan, Golub and LeVeque): the deviations of the two means from the combined
+	 * mean add count_a*count_b/count*delta^2 to the sum of squares.
+	 */
+	if (other.count == 0) { return; }
+	if (count == 0) { *this = other; return; }
+
+	double total = double(count) + double(other.count);
+	double delta = other.mean - mean;
+	mean += delta*(other.count/total);
+	m2 += other.m2 + delta*delta*(count*(other.count/total));
+	count += other.count;
+	minimum = std::min(minimum, other.minimum);
+	maximum = std::max(maximum, other.maximum);
+}
+
+
+histogram::histogram (double lower, double upper, std::size_t bins) : lower(lower), upper(upper), counts(bins, 0) {
+	if (!(upper > lower) || bins == 0) { throw std::runtime_error("histogram: empty range or no bins"); }
+	scale = bins/(upper - lower);
+}
+
+
+void histogram::add(double value) {
+	// NaN counts as underflow
+	if (!(value >= lower)) { underflow++; return; }
+	if (value >= upper) { overflow++; return; }
+
+	// rounding may give counts.size() for values just below upper
+	std::size_t bin = (value - lower)*scale;
+	counts[std::min(bin, counts.size() - 1)]++;
+}
+
+
+void histogram::merge(const histogram & other) {
+	for (std::size_t i=0; i<counts.size(); i++) { counts[i] += other.counts[i]; }
+	underflow += other.underflow;
+	overflow += other.overflow;
+}
+
+
+static const char * map_file(const std::string & file_name, std::size_t & length) {
+	/*
+	 * Maps the whole file read-only, returns a nullptr for empty files.
+	 */
+	int descriptor = open(file_name.c_str(), O_RDONLY);
+	if (descriptor < 0) { throw std::runtime_error(file_name + ": cannot open file"); }
+
+	struct stat status;
+	if (fstat(descriptor, &status) != 0) {
+		close(descriptor);
+		throw std::runtime_error(file_name + ": cannot read the file size");
+	}
+
+	length = status.st_size;
+	if (length == 0) { close(descriptor); return nullptr; }
+
+	void * mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	close(descriptor);
+	if (mapping == MAP_FAILED) { throw std::runtime_error(file_name + ": cannot map file"); }
+
+	return static_cast<const char *>(mapping);
+}
+
+
+static bool skip_field(const char * & position, const char * end) {
+	while (position < end && (*position == '\t' || *position == ' ' || *position == '\r')) { position++; }
+	return position < end;
+}
+
+
+tsv_table::tsv_table (const std::string & file_name) : file_name(file_name) {
+
+	data = map_file(file_name, length);
+	if (data == nullptr) { return; }
+
+	// the header: "#" and the mean of every column
+	if (data[0] == '#') {
+		const char * end = static_cast<const char *>(std::memchr(data, '\n', length));
+		if (end == nullptr) { end = data + length; }
+
+		const char * position = data + 1;
+		while (skip_field(position, end)) {
+			double mean;
+			std::from_chars_result result = std::from_chars(position, end, mean);
+			if (result.ec != std::errc()) { means.clear(); break; }
+			means.push_back(mean);
+			position = result.ptr;
+		}
+		first_row = std::min<std::size_t>(end - data + 1, length);
+	}
+
+	// without (usable) header the columns are counted in the first row
+	column_count = means.size();
+	std::size_t position = first_row;
+	while (column_count == 0 && position < length) {
+		const char * line = data + position;
+		const char * end = static_cast<const char *>(std::memchr(line, '\n', length - position));
+		if (end == nullptr) { end = data + length; }
+
+		if (end != line && *line != '#') {
+			const char * field = static_cast<const char *>(std::memchr(line, '\t', end - line));
+			if (field == nullptr) { throw std::runtime_error(file_name + ": malformed row at byte " + std::to_string(position)); }
+			while (skip_field(field, end)) {
+				while (field < end && *field != '\t' && *field != ' ' && *field != '\r') { field++; }
+				column_count++;
+			}
+			if (column_count == 0) { throw std::runtime_error(file_name + ": row without values at byte " + std::to_string(position)); }
+		}
+		position = end - data + 1;
+	}
+}
+
+
+tsv_table::~tsv_table() {
+	if (data != nullptr) { munmap(const_cast<char *>(data), length); }
+}
+
+
+std::vector<std::pair<double, double> > ranges_around_means(const std::vector<double> & means, std::size_t columns, double half_width) {
+	std::vector<std::pair<double, double> > ranges (columns);
+	for (std::size_t k=0; k<columns; k++) {
+		double center = means.empty() ? 0. : means[k];
+		ranges[k] = std::make_pair(center - half_width, center + half_width);
+	}
+	return ranges;
+}
+
+
+bool tsv_table::parse_row(const char * line, const char * end, double * values) const {
+	/*
+	 * Parses the values of the row [line, end) into values (column_count of them), the sample index is skipped.
+	 * Returns false if the row is malformed.
+	 */
+	const char * position = static_cast<const char *>(std::memchr(line, '\t', end - line));
+	if (position == nullptr) { return false; }
+
+	std::size_t k = 0;
+	while (skip_field(position, end)) {
+		if (k == column_count) { return false; }
+		std::from_chars_result result = std::from_chars(position, end, values[k]);
+		if (result.ec != std::errc()) { return false; }
+		position = result.ptr;
+		k++;
+	}
+	return k == column_count;
+}
+
+
+std::size_t tsv_table::chunk_start(long chunk) const {
+	/*
+	 * A chunk owns the lines which start in [first_row + chunk*chunk_bytes, first_row + (chunk + 1)*chunk_bytes), this is
+	 * the first of them (or the end of the file, or the first line of the next chunk if none starts in the chunk).
+	 */
+	std::size_t begin = first_row + chunk*chunk_bytes;
+	if (chunk == 0 || begin >= length) { return std::min(begin, length); }
+
+	const void * newline = std::memchr(data + begin - 1, '\n', length - begin + 1);
+	return (newline == nullptr) ? length : static_cast<const char *>(newline) - data + 1;
+}
+
+
+table_statistics tsv_table::statistics(std::size_t bins, const std::vector<std::pair<double, double> > & ranges) const {
+	if (!ranges.empty() && ranges.size() != column_count) {
+		throw std::runtime_error(file_name + ": " + std::to_string(ranges.size()) + " histogram ranges for "
+			+ std::to_string(column_count) + " columns");
+	}
+
+	int threads = omp_get_max_threads();
+	std::vector<table_statistics> partial (threads);
+	for (int t=0; t<threads; t++) {
+		partial[t].columns.resize(column_count);
+		for (std::size_t k=0; k<ranges.size(); k++) { partial[t].histograms.emplace_back(ranges[k].first, ranges[k].second, bins); }
+	}
+	if (data == nullptr) { return partial[0]; }
+
+	madvise(const_cast<char *>(data), length, MADV_SEQUENTIAL);
+
+	long chunks = (length - first_row + chunk_bytes - 1)/chunk_bytes;
+	std::vector<std::size_t> failed (threads, length);
+
+	#pragma omp parallel num_threads(threads)
+	{
+		int thread = omp_get_thread_num();
+		table_statistics & local = partial[thread];
+		std::vector<double> values (column_count);
+
+		// round-robin, so the chunks of every thread (and the result) do not depend on the timing
+		#pragma omp for schedule(static, 1)
+		for (long chunk=0; chunk<chunks; chunk++) {
+			std::size_t position = chunk_start(chunk), end = chunk_start(chunk + 1);
+			while (position < end) {
+				const char * line = data + position;
+				const char * stop = static_cast<const char *>(std::memchr(line, '\n', length - position));
+				if (stop == nullptr) { stop = data + length; }
+
+				if (stop != line && *line != '#') {
+					if (!parse_row(line, stop, values.data())) { failed[thread] = std::min(failed[thread], position); break; }
+					local.rows++;
+					for (std::size_t k=0; k<column_count; k++) { local.columns[k].add(values[k]); }
+					for (std::size_t k=0; k<local.histograms.size(); k++) { local.histograms[k].add(values[k]); }
+				}
+
+				position = stop - data + 1;
+			}
+		}
+	}
+
+	std::size_t first_failure = *std::min_element(failed.begin(), failed.end());
+	if (first_failure < length) {
+		throw std::runtime_error(file_name + ": malformed row at byte " + std::to_string(first_failure));
+	}
+
+	table_statistics & result = partial[0];
+	for (int t=1; t<threads; t++) {
+		result.rows += partial[t].rows;
+		for (std::size_t k=0; k<column_count; k++) { result.columns[k].merge(partial[t].columns[k]); }
+		for (std::size_t k=0; k<result.histograms.size(); k++) { result.histograms[k].merge(partial[t].histograms[k]); }
+	}
+	return result;
+}
+
+
+static std::size_t align_to_page(std::size_t offset) {
+	// the columns are aligned for the page cache and for vector loads, independent of the page size of the machine
+	return (offset + 4095)/4096*4096;
+}
+
+
+std::size_t tsv_table::convert_to_columnar(const std::string & binary_file_name, std::size_t block_rows) const {
+	/*
+	 * Two parallel passes over the chunks: the first counts the rows of every chunk, which gives the size of the output and
+	 * the first row of every chunk, the second parses every chunk directly into the columns of the mapped output file.
+	 * Then the min/max of every block are computed from the written columns. Only the pages of the mapped files are used.
+	 */
+	block_rows = std::max<std::size_t>(block_rows, 1);
+	long chunks = (data == nullptr) ? 0 : (length - first_row + chunk_bytes - 1)/chunk_bytes;
+	if (data != nullptr) { madvise(const_cast<char *>(data), length, MADV_SEQUENTIAL); }
+
+	// chunk_rows[chunk] is the first row of the chunk after the prefix sum
+	std::vector<std::size_t> chunk_rows (chunks + 1, 0);
+
+	#pragma omp parallel for schedule(static, 1)
+	for (long chunk=0; chunk<chunks; chunk++) {
+		std::size_t position = chunk_start(chunk), end = chunk_start(chunk + 1), rows = 0;
+		while (position < end) {
+			const char * line = data + position;
+			const char * stop = static_cast<const char *>(std::memchr(line, '\n', length - position));
+			if (stop == nullptr) { stop = data + length; }
+			if (stop != line && *line != '#') { rows++; }
+			position = stop - data + 1;
+		}
+		chunk_rows[chunk + 1] = rows;
+	}
+	for (long chunk=0; chunk<chunks; chunk++) { chunk_rows[chunk + 1] += chunk_rows[chunk]; }
+
+	std::size_t rows = chunk_rows[chunks], blocks = (rows + block_rows - 1)/block_rows;
+	std::size_t column_offset = align_to_page(64 + column_count*sizeof(double)), column_stride = align_to_page(rows*sizeof(double));
+	std::size_t index_offset = column_offset + column_count*column_stride;
+	std::size_t total = index_offset + column_count*blocks*2*sizeof(double);
+
+	int descriptor = open(binary_file_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (descriptor < 0) { throw std::runtime_error(binary_file_name + ": cannot open file"); }
+
+	// the blocks are allocated now: a full disk is an error here, not a SIGBUS when a page of a sparse file is written
+	int error = (total > 0) ? posix_fallocate(descriptor, 0, total) : 0;
+	if (error != 0) {
+		close(descriptor);
+		unlink(binary_file_name.c_str());
+		throw std::runtime_error(binary_file_name + ": cannot reserve " + std::to_string(total) + " bytes (" + std::strerror(error) + ")");
+	}
+	void * mapping = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+	close(descriptor);
+	if (mapping == MAP_FAILED) {
+		unlink(binary_file_name.c_str());
+		throw std::runtime_error(binary_file_name + ": cannot map file");
+	}
+	char * output = static_cast<char *>(mapping);
+
+	std::memcpy(output, "TSVCOLMN", 8);
+	std::uint32_t version = 1, columns = column_count, flags = means.empty() ? 0 : 1;
+	std::uint64_t header[5] = { rows, block_rows, column_offset, column_stride, index_offset };
+	std::memcpy(output + 8, &version, 4);
+	std::memcpy(output + 12, &columns, 4);
+	std::memcpy(output + 16, header, sizeof(header));
+	std::memcpy(output + 56, &flags, 4);
+	if (!means.empty()) { std::memcpy(output + 64, means.data(), column_count*sizeof(double)); }
+
+	std::vector<double *> column (column_count);
+	for (std::size_t k=0; k<column_count; k++) { column[k] = reinterpret_cast<double *>(output + column_offset + k*column_stride); }
+
+	int threads = omp_get_max_threads();
+	std::vector<std::size_t> failed (threads, length);
+
+	#pragma omp parallel num_threads(threads)
+	{
+		int thread = omp_get_thread_num();
+		std::vector<double> values (column_count);
+
+		#pragma omp for schedule(static, 1)
+		for (long chunk=0; chunk<chunks; chunk++) {
+			std::size_t position = chunk_start(chunk), end = chunk_start(chunk + 1), row = chunk_rows[chunk];
+			while (position < end) {
+				const char * line = data + position;
+				const char * stop = static_cast<const char *>(std::memchr(line, '\n', length - position));
+				if (stop == nullptr) { stop = data + length; }
+
+				if (stop != line && *line != '#') {
+					if (!parse_row(line, stop, values.data())) { failed[thread] = std::min(failed[thread], position); break; }
+					for (std::size_t k=0; k<column_count; k++) { column[k][row] = values[k]; }
+					row++;
+				}
+
+				position = stop - data + 1;
+			}
+		}
+	}
+
+	std::size_t first_failure = *std::min_element(failed.begin(), failed.end());
+	if (first_failure < length) {
+		munmap(mapping, total);
+		unlink(binary_file_name.c_str());
+		throw std::runtime_error(file_name + ": malformed row at byte " + std::to_string(first_failure));
+	}
+
+	double * index = reinterpret_cast<double *>(output + index_offset);
+	long entries = column_count*blocks;
+
+	#pragma omp parallel for schedule(static)
+	for (long entry=0; entry<entries; entry++) {
+		std::size_t k = entry/blocks, first = (entry % blocks)*block_rows, last = std::min(first + block_rows, rows);
+		double minimum = std::numeric_limits<double>::infinity(), maximum = -minimum;
+		for (std::size_t i=first; i<last; i++) {
+			minimum = std::min(minimum, column[k][i]);
+			maximum = std::max(maximum, column[k][i]);
+		}
+		index[2*entry] = minimum;
+		index[2*entry + 1] = maximum;
+	}
+
+	// munmap does not report write errors, msync does
+	bool written = (msync(mapping, total, MS_SYNC) == 0);
+	munmap(mapping, total);
+	if (!written) {
+		unlink(binary_file_name.c_str());
+		throw std::runtime_error(binary_file_name + ": write failed");
+	}
+	return rows;
+}
+
+
+columnar_table::columnar_table (const std::string & file_name) : file_name(file_name) {
+
+	data = map_file(file_name, length);
+	if (data == nullptr || length < 64 || std::memcmp(data, "TSVCOLMN", 8) != 0) {
+		if (data != nullptr) { munmap(const_cast<char *>(data), length); }
+		throw std::runtime_error(file_name + ": not a columnar table file");
+	}
+
+	std::uint32_t version, columns, flags;
+	std::uint64_t header[5];
+	std::memcpy(&version, data + 8, 4);
+	std::memcpy(&columns, data + 12, 4);
+	std::memcpy(header, data + 16, sizeof(header));
+	std::memcpy(&flags, data + 56, 4);
+
+	column_count = columns;
+	row_count = header[0];
+	rows_per_block = header[1];
+	column_offset = header[2];
+	column_stride = header[3];
+	std::size_t index_offset = header[4];
+
+	bool valid = version == 1 && rows_per_block > 0 && column_offset >= 64 + column_count*sizeof(double)
+		&& column_offset % sizeof(double) == 0 && column_stride >= row_count*sizeof(double) && column_stride % sizeof(double) == 0
+		&& index_offset >= column_offset + column_count*column_stride && index_offset % sizeof(double) == 0
+		&& length >= index_offset + column_count*blocks()*2*sizeof(double);
+	if (!valid) {
+		munmap(const_cast<char *>(data), length);
+		throw std::runtime_error(file_name + ": unsupported version or truncated file");
+	}
+
+	if (flags & 1) {
+		means.resize(column_count);
+		std::memcpy(means.data(), data + 64, column_count*sizeof(double));
+	}
+	block_index = reinterpret_cast<const double *>(data + index_offset);
+}
+
+
+columnar_table::~columnar_table() {
+	if (data != nullptr) { munmap(const_cast<char *>(data), length); }
+}
+
+
+const double * columnar_table::column(std::size_t index) const {
+	if (index >= column_count) { throw std::runtime_error(file_name + ": column " + std::to_string(index) + " does not exist"); }
+	return reinterpret_cast<const double *>(data + column_offset + index*column_stride);
+}
+
+
+table_statistics columnar_table::statistics(std::size_t bins, const std::vector<std::pair<double, double> > & ranges) const {
+	/*
+	 * Every block is reduced in two passes (sum, then squared deviations from the block mean, while it is in the cache),
+	 * its min/max are taken from the block index. The blocks are merged per thread and the threads in their order.
+	 */
+	if (!ranges.empty() && ranges.size() != column_count) {
+		throw std::runtime_error(file_name + ": " + std::to_string(ranges.size()) + " histogram ranges for "
+			+ std::to_string(column_count) + " columns");
+	}
+
+	table_statistics result;
+	result.rows = row_count;
+	result.columns.resize(column_count);
+
+	int threads = omp_get_max_threads();
+	long block_count = blocks();
+
+	for (std::size_t k=0; k<column_count; k++) {
+		const double * values = column(k);
+		std::vector<column_statistics> partial (threads);
+		std::vector<histogram> partial_histograms;
+		if (!ranges.empty()) { partial_histograms.assign(threads, histogram(ranges[k].first, ranges[k].second, bins)); }
+
+		#pragma omp parallel num_threads(threads)
+		{
+			int thread = omp_get_thread_num();
+
+			#pragma omp for schedule(static)
+			for (long block=0; block<block_count; block++) {
+				std::size_t first = block*rows_per_block, count = std::min(rows_per_block, row_count - first);
+
+				double sum = 0;
+				for (std::size_t i=first; i<first+count; i++) { sum += values[i]; }
+
+				column_statistics block_result;
+				block_result.count = count;
+				block_result.mean = sum/count;
+				for (std::size_t i=first; i<first+count; i++) {
+					double deviation = values[i] - block_result.mean;
+					block_result.m2 += deviation*deviation;
+				}
+				block_result.minimum = block_minimum(k, block);
+				block_result.maximum = block_maximum(k, block);
+				partial[thread].merge(block_result);
+
+				if (!partial_histograms.empty()) {
+					for (std::size_t i=first; i<first+count; i++) { partial_histograms[thread].add(values[i]); }
+				}
+			}
+		}
+
+		for (int t=0; t<threads; t++) { result.columns[k].merge(partial[t]); }
+		if (!partial_histograms.empty()) {
+			for (int t=1; t<threads; t++) { partial_histograms[0].merge(partial_histograms[t]); }
+			result.histograms.push_back(partial_histograms[0]);
+		}
+	}
+
+	return result;
+}
+
+
+std::size_t columnar_table::count_in_range(std::size_t column_index, double lower, double upper, std::size_t * blocks_read) const {
+	const double * values = column(column_index);
+	long block_count = blocks();
+	std::size_t count = 0, read = 0;
+
+	#pragma omp parallel for schedule(static) reduction(+:count, read)
+	for (long block=0; block<block_count; block++) {
+		double minimum = block_minimum(column_index, block), maximum = block_maximum(column_index, block);
+		std::size_t first = block*rows_per_block, last = std::min(first + rows_per_block, row_count);
+
+		// blocks completely outside or inside the range are not read
+		if (maximum < lower || minimum >= upper) { continue; }
+		if (minimum >= lower && maximum < upper) { count += last - first; continue; }
+
+		read++;
+		for (std::size_t i=first; i<last; i++) { count += (values[i] >= lower && values[i] < upper); }
+	}
+
+	if (blocks_read != nullptr) { *blocks_read = read; }
+	return count;
+}
+
+
+static void write_text(const char * text, std::size_t size, std::FILE * file, const std::string & file_name) {
+	if (std::fwrite(text, 1, size, file) != size) {
+		std::fclose(file);
+		throw std::runtime_error(file_name + ": write failed");
+	}
+}
+
+
+void write_random_table(const std::string & file_name, std::size_t samples, std::size_t columns, std::uint64_t seed) {
+	/*
+	 * The values are generated and formatted (shortest representation, like str() in Python) in blocks of rows.
+	 */
+	std::FILE * file = std::fopen(file_name.c_str(), "w");
+	if (file == nullptr) { throw std::runtime_error(file_name + ": cannot open file for writing"); }
+
+	const std::size_t block_rows = 16384;
+	std::vector<double> means (columns), values (block_rows*columns);
+	std::vector<char> text ((block_rows + 1)*(columns + 1)*32);
+	fill_uniform(means.data(), columns, seed, -5., 5.);
+
+	char * position = text.data();
+	*position++ = '#';
+	*position++ = '\t';
+	for (std::size_t k=0; k<columns; k++) {
+		position = std::to_chars(position, text.data() + text.size(), means[k]).ptr;
+		*position++ = '\t';
+	}
+	*position++ = '\n';
+	write_text(text.data(), position - text.data(), file, file_name);
+
+	for (std::size_t first=0; first<samples; first+=block_rows) {
+		std::size_t rows = std::min(block_rows, samples - first);
+		fill_normal(values.data(), rows*columns, seed + 1 + first/block_rows);
+
+		position = text.data();
+		for (std::size_t i=0; i<rows; i++) {
+			position = std::to_chars(position, text.data() + text.size(), first + i).ptr;
+			*position++ = '\t';
+			for (std::size_t k=0; k<columns; k++) {
+				position = std::to_chars(position, text.data() + text.size(), means[k] + values[i*columns + k]).ptr;
+				*position++ = '\t';
+			}
+			*position++ = '\n';
+		}
+
+		write_text(text.data(), position - text.data(), file, file_name);
+	}
+
+	if (std::fclose(file) != 0) { throw std::runtime_error(file_name + ": write failed"); }
+}
@@ -0,0 +1,166 @@
+/* FILE COLUMN_STATS.HPP */
+#ifndef FILE_COLUMN_STATS_HPP
+#define FILE_COLUMN_STATS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Reader for the tables of data_creator.py: tab separated text, one sample per line, the first field is the sample index
+ * and the others are the values of the columns (a trailing tab is allowed). An optional first line "#\t" followed by one
+ * number per column holds the means the data was drawn from. Other lines starting with '#' and empty lines are skipped.
+ *
+ * The file is memory-mapped. statistics() makes one pass over it: the mapping is cut into chunks of chunk_bytes, every
+ * chunk owns the lines which start in it, and the chunks are dealt round-robin to the OpenMP threads. Each thread parses
+ * its lines with std::from_chars into a running mean/variance (Welford), min/max and a histogram per column. At the end the
+ * thread results are merged in thread order (Chan et al.), so the result only depends on the number of threads.
+ * The memory used is threads x columns x (statistics + histogram bins), independent of the size of the file.
+ *
+ * Since there is only one pass, the histogram ranges have to be known in advance: either given explicitly or taken
+ * around the means of the header (ranges_around_means). Values outside the range are counted as underflow/overflow.
+ *
+ * Malformed lines (a value which is not a number, too few or too many values) throw a std::runtime_error with the byte
+ * offset of the first such line.
+ *
+ * Since parsing the text dominates every analysis, convert_to_columnar writes the table once in a binary format which
+ * columnar_table maps again without parsing (the constructor only checks the header, the columns are read from the disk
+ * when they are first used, so an analysis of some columns only reads those):
+ *	header (64 bytes): char magic[8] = "TSVCOLMN", uint32 version = 1, uint32 column count, uint64 row count,
+ *	                   uint64 rows per block, uint64 offset of column 0, uint64 bytes from one column to the next,
+ *	                   uint64 offset of the block index, uint32 flags (1: the text had a header of means), zero padding
+ *	means:             column count doubles (zero without header)
+ *	columns:           row count doubles per column, every column starts at a multiple of 4096 bytes
+ *	block index:       per column and block of rows: min and max (doubles) of the column in the block
+ * All numbers are stored in the byte order of the machine that wrote the file (little endian on x86).
+ * The block index lets queries skip the blocks which cannot contain values in a range (see count_in_range), which pays off
+ * for data with some order (e.g. sorted or slowly varying columns) and for ranges in the tails.
+ */
+
+class column_statistics {
+	public:
+		std::uint64_t count = 0;
+		double mean = 0;
+		double m2 = 0;	// sum of the squared deviations from the mean
+		double minimum = std::numeric_limits<double>::infinity();
+		double maximum = -std::numeric_limits<double>::infinity();
+
+		void add(double value);
+		void merge(const column_statistics & other);
+
+		// sample variance (divided by count - 1)
+		double variance() const { return (count > 1) ? m2/(count - 1) : 0.; }
+};
+
+
+class histogram {
+	public:
+		double lower = 0, upper = 0;
+		std::vector<std::uint64_t> counts;
+		std::uint64_t underflow = 0, overflow = 0;
+
+		histogram () = default;
+		histogram (double lower, double upper, std::size_t bins);
+
+		void add(double value);
+		void merge(const histogram & other);
+
+		double bin_width() const { return (upper - lower)/counts.size(); }
+
+	private:
+		double scale = 0;	// bins per unit
+};
+
+
+class table_statistics {
+	public:
+		std::uint64_t rows = 0;
+		std::vector<column_statistics> columns;
+		std::vector<histogram> histograms;
+};
+
+
+class tsv_table {
+	public:
+		static const std::size_t chunk_bytes = std::size_t(1) << 23;
+
+		tsv_table (const std::string & file_name);
+		~tsv_table();
+
+		tsv_table (const tsv_table &) = delete;
+		tsv_table & operator = (const tsv_table &) = delete;
+
+		std::size_t columns() const { return column_count; }
+
+		// the means of the header line, empty if the file has none
+		const std::vector<double> & header_means() const { return means; }
+
+		// one pass over the file, ranges has one entry per column (no histograms if it is empty)
+		table_statistics statistics(std::size_t bins, const std::vector<std::pair<double, double> > & ranges) const;
+
+		// writes the table in the columnar format with a min/max per block of block_rows rows, returns the number of rows
+		std::size_t convert_to_columnar(const std::string & binary_file_name, std::size_t block_rows = 65536) const;
+
+	private:
+		const char * data = nullptr;
+		std::size_t length = 0;
+		std::string file_name;
+
+		std::size_t first_row = 0;	// offset after the header line
+		std::size_t column_count = 0;
+		std::vector<double> means;
+
+		bool parse_row(const char * line, const char * end, double * values) const;
+		std::size_t chunk_start(long chunk) const;
+};
+
+
+class columnar_table {
+	public:
+		columnar_table (const std::string & file_name);
+		~columnar_table();
+
+		columnar_table (const columnar_table &) = delete;
+		columnar_table & operator = (const columnar_table &) = delete;
+
+		std::size_t rows() const { return row_count; }
+		std::size_t columns() const { return column_count; }
+		const std::vector<double> & header_means() const { return means; }
+
+		// the values of a column, valid as long as the object exists
+		const double * column(std::size_t index) const;
+
+		std::size_t block_rows() const { return rows_per_block; }
+		std::size_t blocks() const { return (row_count + rows_per_block - 1)/rows_per_block; }
+		double block_minimum(std::size_t column, std::size_t block) const { return block_index[2*(column*blocks() + block)]; }
+		double block_maximum(std::size_t column, std::size_t block) const { return block_index[2*(column*blocks() + block) + 1]; }
+
+		// the same results as tsv_table::statistics (up to rounding), in parallel over the blocks of every column
+		table_statistics statistics(std::size_t bins, const std::vector<std::pair<double, double> > & ranges) const;
+
+		// number of values of the column in [lower, upper), only the blocks which are neither outside nor inside are read
+		std::size_t count_in_range(std::size_t column, double lower, double upper, std::size_t * blocks_read = nullptr) const;
+
+	private:
+		const char * data = nullptr;
+		std::size_t length = 0;
+		std::string file_name;
+
+		std::size_t column_count = 0, row_count = 0, rows_per_block = 1;
+		std::size_t column_offset = 0, column_stride = 0;
+		std::vector<double> means;
+		const double * block_index = nullptr;
+};
+
+
+// histogram range [mean - half_width, mean + half_width) for every column (mean 0 without header means)
+std::vector<std::pair<double, double> > ranges_around_means(const std::vector<double> & means, std::size_t columns, double half_width);
+
+
+// writes a table like data_creator.py (normal distributions with unit variance around random means in [-5, 5))
+void write_random_table(const std::string & file_name, std::size_t samples, std::size_t columns, std::uint64_t seed);
+
+#endif /* FILE_COLUMN_STATS_HPP */
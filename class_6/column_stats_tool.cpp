@@ -0,0 +1,135 @@
+#include "column_stats.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+/*
+ * Command line interface of column_stats.hpp:
+ *
+ *	./column_stats.out FILE [BINS [LOWER UPPER]]
+ *		count, mean (and the mean of the header), standard deviation, min and max of every column, and a histogram of BINS
+ *		bins (default 20) in [LOWER, UPPER) or, without range, in [mean - 5, mean + 5) around the mean of the header
+ *	./column_stats.out generate FILE SAMPLES COLUMNS [SEED]
+ *		writes a table like data_creator.py with SAMPLES rows (e.g. for files larger than the memory)
+ *	./column_stats.out convert FILE BINARY_FILE [BLOCK_ROWS]
+ *		converts the table to the columnar format with the min/max of every BLOCK_ROWS rows (default 65536)
+ *	./column_stats.out binary BINARY_FILE [BINS [LOWER UPPER]]
+ *		the statistics like for FILE, from the columnar file
+ *	./column_stats.out count BINARY_FILE COLUMN LOWER UPPER
+ *		number of values of the column in [LOWER, UPPER), using the block min/max
+ *
+ * The number of threads is set with OMP_NUM_THREADS.
+ */
+
+static void print_statistics(const std::vector<double> & means, const table_statistics & statistics) {
+	std::cout << "column\tcount\tmean\theader mean\tstd deviation\tmin\tmax" << std::endl;
+	for (std::size_t k=0; k<statistics.columns.size(); k++) {
+		const column_statistics & column = statistics.columns[k];
+		std::cout << k << '\t' << column.count << '\t' << column.mean << '\t';
+		if (means.empty()) { std::cout << '-'; }
+		else { std::cout << means[k]; }
+		std::cout << '\t' << std::sqrt(column.variance()) << '\t' << column.minimum << '\t' << column.maximum << std::endl;
+	}
+
+	for (std::size_t k=0; k<statistics.histograms.size(); k++) {
+		const histogram & bins = statistics.histograms[k];
+		std::cout << std::endl << "column " << k << ": " << bins.underflow << " below " << bins.lower << ", "
+			<< bins.overflow << " at or above " << bins.upper << std::endl;
+		for (std::size_t i=0; i<bins.counts.size(); i++) {
+			std::cout << '\t' << bins.lower + i*bins.bin_width() << '\t' << bins.counts[i] << std::endl;
+		}
+	}
+}
+
+
+static std::vector<std::pair<double, double> > histogram_ranges(int argc, char **argv, int bins_argument,
+		const std::vector<double> & means, std::size_t columns) {
+	// LOWER UPPER after BINS for all columns, otherwise around the means
+	if (argc == bins_argument + 3) {
+		return std::vector<std::pair<double, double> > (columns, std::make_pair(std::atof(argv[bins_argument + 1]), std::atof(argv[bins_argument + 2])));
+	}
+	return ranges_around_means(means, columns, 5.);
+}
+
+
+int main(int argc, char **argv) {
+	std::string command = (argc > 1) ? argv[1] : "";
+
+	bool valid;
+	if (command == "generate") { valid = (argc == 5 || argc == 6); }
+	else if (command == "convert") { valid = (argc == 4 || argc == 5); }
+	else if (command == "binary") { valid = (argc == 3 || argc == 4 || argc == 6); }
+	else if (command == "count") { valid = (argc == 6); }
+	else { valid = (argc == 2 || argc == 3 || argc == 5); }
+
+	if (!valid) {
+		std::cerr << "Usage: ./column_stats.out FILE [BINS [LOWER UPPER]] | generate FILE SAMPLES COLUMNS [SEED]"
+			<< " | convert FILE BINARY_FILE [BLOCK_ROWS] | binary BINARY_FILE [BINS [LOWER UPPER]]"
+			<< " | count BINARY_FILE COLUMN LOWER UPPER" << std::endl;
+		return 1;
+	}
+
+	try {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		if (command == "generate") {
+			std::uint64_t seed = (argc == 6) ? std::strtoull(argv[5], nullptr, 10) : 1;
+			write_random_table(argv[2], std::strtoull(argv[3], nullptr, 10), std::strtoull(argv[4], nullptr, 10), seed);
+			return 0;
+		}
+
+		if (command == "convert") {
+			tsv_table table (argv[2]);
+			std::size_t block_rows = (argc == 5) ? std::strtoul(argv[4], nullptr, 10) : 65536;
+			std::size_t rows = table.convert_to_columnar(argv[3], block_rows);
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			std::cout << rows << " rows, " << table.columns() << " columns written to " << argv[3] << " in " << seconds << " s" << std::endl;
+			return 0;
+		}
+
+		if (command == "count") {
+			columnar_table table (argv[2]);
+			std::size_t blocks_read;
+			std::size_t count = table.count_in_range(std::strtoul(argv[3], nullptr, 10), std::atof(argv[4]), std::atof(argv[5]), &blocks_read);
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			std::cout << count << " of " << table.rows() << " values in [" << argv[4] << ", " << argv[5] << "), "
+				<< blocks_read << " of " << table.blocks() << " blocks read in " << seconds << " s" << std::endl;
+			return 0;
+		}
+
+		table_statistics statistics;
+		std::vector<double> means;
+		std::size_t columns;
+		int bins_argument = (command == "binary") ? 3 : 2;
+		std::size_t bins = (argc > bins_argument) ? std::strtoul(argv[bins_argument], nullptr, 10) : 20;
+
+		if (command == "binary") {
+			columnar_table table (argv[2]);
+			means = table.header_means();
+			columns = table.columns();
+			statistics = table.statistics(bins, histogram_ranges(argc, argv, bins_argument, means, columns));
+		}
+		else {
+			tsv_table table (argv[1]);
+			means = table.header_means();
+			columns = table.columns();
+			statistics = table.statistics(bins, histogram_ranges(argc, argv, bins_argument, means, columns));
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		std::cout << std::setprecision(8);
+		print_statistics(means, statistics);
+		std::cerr << statistics.rows << " rows, " << columns << " columns in " << seconds << " s" << std::endl;
+	}
+	catch (std::exception & error) {
+		std::cerr << error.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -2,15 +2,11 @@
 #include <exception>
 #include <string>
 
+#include "unrolled_list.hpp"
 
 
-static const int max_element_count = 100;
 
-class list_element {
-	public:
-		int value;
-		list_element * next;
-};
+static const int max_element_count = 100;
 
 
 class premature_list_end_exception : public std::exception {
@@ -37,48 +33,44 @@ namespace ERRORS {
 }
 
 
-void build_zeroed_list(int element_count, list_element * first_node) {
+void build_zeroed_list(int element_count, unrolled_list & list) {
 	/*
-	 * Initializes an empty list with element_count elements, with value 0.
+	 * Initializes a list which consists of its first element with element_count elements, with value 0
+	 * (the first element counts, as with the first list_element node: 0 and 1 leave the list at one element).
 	 * The list can be at most 100 elements long, else an exception is thrown.
+	 * The list owns its nodes, they are freed with it even if an exception is thrown.
 	 */
 
 	if (element_count > max_element_count) {
 		throw 1;
 	}
 
-	list_element * current = first_node;
-
 	for (int i=0; i<element_count-1; i++) {
-		list_element * next_element = new list_element;
-		current->next = next_element;
-		current->value = 0;
-		current = current->next;
+		list.push_back(0);
 	}
-	current->next = nullptr;
 
 }
 
 
-void print_list_elements(int list_length, list_element * first_node) {
+void print_list_elements(int list_length, const unrolled_list & list) {
 
-	list_element * current = first_node;
+	unrolled_list::const_iterator current = list.begin();
 
 	for (int i=0; i<list_length; i++) {
-		if (current == nullptr) {
+		if (current == list.end()) {
 			throw new premature_list_end_exception;
 		}
-		std::cout << "element number: " << i+1 << ", has value: " << current->value << std::endl;
-		current = current->next;
+		std::cout << "element number: " << i+1 << ", has value: " << *current << std::endl;
+		++current;
 	}
 
-	if (current != nullptr) {
+	if (current != list.end()) {
 		throw 2;
 	}
 }
 
 
-int get_list_sum(int list_length, list_element * first_node)
+int get_list_sum(int list_length, const unrolled_list & list)
 {
 	if (list_length == 42) {
 		throw new premature_list_end_exception;
@@ -87,22 +79,14 @@ int get_list_sum(int list_length, list_element * first_node)
 		throw ERRORS::LIST_TOO_LONG;
 	}
 
-	list_element * current = first_node;
-	int sum = 0;
-
-	for (int i=0; i<list_length; i++) {
-		if (current == nullptr) {
-			throw ERRORS::LIST_END_REACHED_PREMATURELY;
-		}
-		sum += current->value;
-		current = current->next;
+	if (list.size() < (std::size_t) list_length) {
+		throw ERRORS::LIST_END_REACHED_PREMATURELY;
 	}
-
-	if (current != nullptr) {
+	if (list.size() > (std::size_t) list_length) {
 		throw ERRORS::LIST_END_NOT_REACHED;
 	}
 
-	return sum;
+	return list.sum();
 }
 
 int main() {
@@ -111,7 +95,9 @@ int main() {
 	std::cout << "Number of elements in the list: ";
 	std::cin >> element_count;
 
-	list_element * first = new list_element;
+	// like the first list_element of the exercise, the list starts with one element
+	unrolled_list first;
+	first.push_back(0);
 
 	try {
 		build_zeroed_list(element_count, first);
@@ -132,7 +118,8 @@ int main() {
 
 
 
-	list_element * other = new list_element;
+	unrolled_list other;
+	other.push_back(0);
 
 	try {
 		build_zeroed_list(80, other);
@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <malloc.h>
+
+#include "unrolled_list.hpp"
+
+/*
+ * Build, sum and destruction times of unrolled_list compared to the list_element chains of exception_test.cpp (one new per
+ * element, the sum walks pointer by pointer like get_list_sum).
+ *
+ * Usage: ./list_benchmark.out [count]   (default 10^7 elements)
+ *
+ * The chain is timed twice: linked in allocation order (consecutive news are mostly adjacent in memory) and linked in a
+ * random order of the same nodes, like a list whose nodes were allocated at different times.
+ */
+
+class list_element {
+	public:
+		int value;
+		list_element * next;
+};
+
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+static void report(const char * name, double seconds, std::size_t count) {
+	std::cout << "\t" << name << ": " << seconds << " s (" << seconds/count*1e9 << " ns/element)" << std::endl;
+}
+
+
+static long long chain_sum(const list_element * current) {
+	long long sum = 0;
+	while (current != nullptr) {
+		sum += current->value;
+		current = current->next;
+	}
+	return sum;
+}
+
+
+static void chain_benchmark(std::size_t count, bool shuffled) {
+	std::cout << "list_element chain (" << (shuffled ? "random link order" : "allocation order") << "):" << std::endl;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::vector<list_element *> nodes (count);
+	for (std::size_t i=0; i<count; i++) {
+		nodes[i] = new list_element;
+		nodes[i]->value = i % 1000;
+	}
+	if (shuffled) {
+		std::mt19937_64 generator (1);
+		std::shuffle(nodes.begin(), nodes.end(), generator);
+	}
+	for (std::size_t i=0; i+1<count; i++) { nodes[i]->next = nodes[i+1]; }
+	nodes[count - 1]->next = nullptr;
+	list_element * first = nodes[0];
+	if (!shuffled) { report("build", seconds_since(start), count); }
+	std::vector<list_element *>().swap(nodes);
+
+	start = std::chrono::steady_clock::now();
+	long long sum = chain_sum(first);
+	report("sum", seconds_since(start), count);
+	std::cout << "\t(sum " << sum << ")" << std::endl;
+
+	/*
+	 * glibc keeps the freed small nodes unmerged in its fast bins, they are merged by the next large allocation
+	 * (which would be the first slab of the unrolled list). malloc_trim does this now, it is part of the delete time.
+	 */
+	start = std::chrono::steady_clock::now();
+	while (first != nullptr) {
+		list_element * next = first->next;
+		delete first;
+		first = next;
+	}
+	malloc_trim(0);
+	report("delete", seconds_since(start), count);
+}
+
+
+int main(int argc, char **argv) {
+	std::size_t count = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+	std::cout << count << " elements, " << unrolled_node::capacity << " values per unrolled node" << std::endl;
+
+	chain_benchmark(count, false);
+	chain_benchmark(count, true);
+
+	std::cout << "unrolled_list:" << std::endl;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	{
+		unrolled_list list;
+		for (std::size_t i=0; i<count; i++) { list.push_back(i % 1000); }
+		report("build", seconds_since(start), count);
+		std::cout << "\t(" << list.allocated_bytes()/1e6 << " MB of nodes)" << std::endl;
+
+		start = std::chrono::steady_clock::now();
+		long long sum = list.sum();
+		report("sum", seconds_since(start), count);
+
+		start = std::chrono::steady_clock::now();
+		int maximum = list.reduce(0, [](int a, int b) { return std::max(a, b); });
+		report("reduce (max)", seconds_since(start), count);
+
+		start = std::chrono::steady_clock::now();
+		long long iterated = 0;
+		for (int value : list) { iterated += value; }
+		report("iterator sum", seconds_since(start), count);
+		std::cout << "\t(sum " << sum << ", iterator sum " << iterated << ", max " << maximum << ")" << std::endl;
+
+		start = std::chrono::steady_clock::now();
+	}
+	report("destruction", seconds_since(start), count);
+
+	return 0;
+}
@@ -0,0 +1,115 @@
+#include "unrolled_list.hpp"
+
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+
+const int unrolled_node::capacity;
+const std::size_t node_pool::slab_nodes;
+
+
+node_pool::node_pool (node_pool && other) : slabs(std::move(other.slabs)), used(other.used), free_nodes(other.free_nodes) {
+	other.slabs.clear();
+	other.used = slab_nodes;
+	other.free_nodes = nullptr;
+}
+
+
+node_pool & node_pool::operator = (node_pool && other) {
+	if (this != &other) {
+		release_all();
+		std::swap(slabs, other.slabs);
+		std::swap(used, other.used);
+		std::swap(free_nodes, other.free_nodes);
+	}
+	return *this;
+}
+
+
+unrolled_node * node_pool::allocate() {
+	if (free_nodes != nullptr) {
+		unrolled_node * node = free_nodes;
+		free_nodes = node->next;
+		return node;
+	}
+
+	if (used == slab_nodes) {
+		// the slab is registered before anything else can throw, so it is always freed
+		slabs.reserve(slabs.size() + 1);
+		void * memory;
+		if (posix_memalign(&memory, cache_line_bytes, slab_nodes*sizeof(unrolled_node)) != 0) { throw std::bad_alloc(); }
+		slabs.push_back(static_cast<unrolled_node *>(memory));
+		used = 0;
+	}
+
+	return &slabs.back()[used++];
+}
+
+
+void node_pool::release(unrolled_node * node) {
+	node->next = free_nodes;
+	free_nodes = node;
+}
+
+
+void node_pool::release_all() {
+	for (std::size_t i=0; i<slabs.size(); i++) { std::free(slabs[i]); }
+	slabs.clear();
+	used = slab_nodes;
+	free_nodes = nullptr;
+}
+
+
+unrolled_list::unrolled_list (unrolled_list && other) : pool(std::move(other.pool)), first(other.first), last(other.last),
+		count(other.count) {
+	other.first = other.last = nullptr;
+	other.count = 0;
+}
+
+
+unrolled_list & unrolled_list::operator = (unrolled_list && other) {
+	if (this != &other) {
+		pool = std::move(other.pool);
+		first = other.first;
+		last = other.last;
+		count = other.count;
+		other.first = other.last = nullptr;
+		other.count = 0;
+	}
+	return *this;
+}
+
+
+void unrolled_list::push_back(int value) {
+	if (last == nullptr || last->count == unrolled_node::capacity) {
+		// allocate may throw, the list is unchanged then
+		unrolled_node * node = pool.allocate();
+		node->count = 0;
+		node->next = nullptr;
+		if (last == nullptr) { first = node; }
+		else { last->next = node; }
+		last = node;
+	}
+	last->values[last->count++] = value;
+	count++;
+}
+
+
+void unrolled_list::clear() {
+	pool.release_all();
+	first = last = nullptr;
+	count = 0;
+}
+
+
+long long unrolled_list::sum() const {
+	long long result = 0;
+	for (const unrolled_node * node=first; node!=nullptr; node=node->next) {
+		// a separate partial sum per node, so that the loop over the values vectorizes
+		long long partial = 0;
+		for (int i=0; i<node->count; i++) { partial += node->values[i]; }
+		result += partial;
+	}
+	return result;
+}
@@ -0,0 +1,131 @@
+/* FILE UNROLLED_LIST.HPP */
+#ifndef FILE_UNROLLED_LIST_HPP
+#define FILE_UNROLLED_LIST_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+/*
+ * Unrolled linked list of ints: every node holds up to unrolled_node::capacity values in an array and fills exactly one
+ * cache line, so a walk over the list loads one line per 13 values instead of one pointer per value, and the loops over
+ * the values of a node vectorize.
+ *
+ * The nodes come from the node_pool of the list, which allocates them in slabs of 1024 cache line aligned nodes (64 kB)
+ * and keeps released nodes on a free list. All slabs are freed at once by clear() and by the destructor, so the list owns
+ * its nodes (RAII): nothing leaks if an exception leaves the scope of the list. Lists can be moved, not copied.
+ *
+ *	push_back(value)            appends a value (O(1), fills the last node before a new one is taken)
+ *	begin(), end()              forward iteration over the values (range-based for)
+ *	sum()                       sum of all values (as long long), node by node with a vectorized inner loop
+ *	reduce(initial, combine)    combine(...combine(initial, v0)..., vn-1) in list order
+ */
+
+const std::size_t cache_line_bytes = 64;
+
+class unrolled_node {
+	public:
+		static const int capacity = (cache_line_bytes - sizeof(unrolled_node *) - sizeof(int))/sizeof(int);
+
+		int values[capacity];
+		int count;
+		unrolled_node * next;
+};
+
+
+class node_pool {
+	public:
+		node_pool() {}
+		~node_pool() { release_all(); }
+
+		node_pool (const node_pool &) = delete;
+		node_pool & operator = (const node_pool &) = delete;
+		node_pool (node_pool && other);
+		node_pool & operator = (node_pool && other);
+
+		// throws std::bad_alloc
+		unrolled_node * allocate();
+		// the node can be handed out again by allocate
+		void release(unrolled_node * node);
+		// frees all slabs, all nodes of the pool become invalid
+		void release_all();
+
+		std::size_t allocated_bytes() const { return slabs.size()*slab_nodes*sizeof(unrolled_node); }
+
+	private:
+		static const std::size_t slab_nodes = 1024;
+
+		std::vector<unrolled_node *> slabs;
+		// nodes of the last slab handed out so far
+		std::size_t used = slab_nodes;
+		unrolled_node * free_nodes = nullptr;
+};
+
+
+class unrolled_list {
+	public:
+		class const_iterator {
+			public:
+				typedef std::forward_iterator_tag iterator_category;
+				typedef int value_type;
+				typedef std::ptrdiff_t difference_type;
+				typedef const int * pointer;
+				typedef const int & reference;
+
+				const_iterator (const unrolled_node * node = nullptr, int index = 0) : node(node), index(index) {}
+
+				reference operator * () const { return node->values[index]; }
+				pointer operator -> () const { return &node->values[index]; }
+
+				const_iterator & operator ++ () {
+					if (++index == node->count) {
+						node = node->next;
+						index = 0;
+					}
+					return *this;
+				}
+				const_iterator operator ++ (int) { const_iterator previous = *this; ++*this; return previous; }
+
+				bool operator == (const const_iterator & other) const { return node == other.node && index == other.index; }
+				bool operator != (const const_iterator & other) const { return !(*this == other); }
+
+			private:
+				const unrolled_node * node;
+				int index;
+		};
+
+		unrolled_list() {}
+
+		unrolled_list (const unrolled_list &) = delete;
+		unrolled_list & operator = (const unrolled_list &) = delete;
+		unrolled_list (unrolled_list && other);
+		unrolled_list & operator = (unrolled_list && other);
+
+		void push_back(int value);
+		void clear();
+
+		std::size_t size() const { return count; }
+		bool empty() const { return count == 0; }
+		std::size_t allocated_bytes() const { return pool.allocated_bytes(); }
+
+		const_iterator begin() const { return const_iterator(first); }
+		const_iterator end() const { return const_iterator(); }
+
+		long long sum() const;
+
+		template <class T, class operation>
+		T reduce(T result, operation combine) const {
+			for (const unrolled_node * node=first; node!=nullptr; node=node->next) {
+				for (int i=0; i<node->count; i++) { result = combine(result, node->values[i]); }
+			}
+			return result;
+		}
+
+	private:
+		node_pool pool;
+		unrolled_node * first = nullptr;
+		unrolled_node * last = nullptr;
+		std::size_t count = 0;
+};
+
+#endif /* FILE_UNROLLED_LIST_HPP */
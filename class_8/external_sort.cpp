@@ -0,0 +1,114 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <omp.h>
+
+#include "bulk_random.hpp"
+#include "external_sort.hpp"
+
+/*
+ * External sort of binary files of doubles (external_sort.hpp).
+ *
+ * Usage: ./external_sort generate file value_count           writes random doubles in [0, 1)
+ *        ./external_sort sort input output [memory_MB] [temporary_directory]   (default 1024 MB, the output directory)
+ *        ./external_sort check file                          checks that the file is sorted
+ *
+ * sort prints the throughput of both phases in MB/s (bytes read + written per second) and the input size per second.
+ */
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+static void generate(const std::string & file_name, std::size_t value_count) {
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	int output = external_sort_open(file_name, true);
+
+	// every block has its own seed
+	std::vector<double> block (1 << 20);
+
+	for (std::size_t first=0; first<value_count; first+=block.size()) {
+		std::size_t count = std::min(block.size(), value_count - first);
+		fill_uniform(block.data(), count, 1 + first/block.size());
+		external_sort_write(output, block.data(), count*sizeof(double), file_name);
+	}
+	close(output);
+
+	double seconds = seconds_since(start);
+	std::cout << "wrote " << value_count << " values in " << seconds << " s (" << value_count*sizeof(double)/seconds/1e6 << " MB/s)"
+		<< std::endl;
+}
+
+
+static int check(const std::string & file_name) {
+	int input = external_sort_open(file_name, false);
+	struct stat information;
+	fstat(input, &information);
+	std::size_t value_count = information.st_size/sizeof(double);
+
+	std::vector<double> block (1 << 20);
+	double previous = -std::numeric_limits<double>::infinity();
+	for (std::size_t first=0; first<value_count; first+=block.size()) {
+		std::size_t count = std::min(block.size(), value_count - first);
+		external_sort_read(input, block.data(), count*sizeof(double), file_name);
+		for (std::size_t i=0; i<count; i++) {
+			if (block[i] < previous) {
+				std::cout << file_name << ": not sorted at value " << first + i << std::endl;
+				close(input);
+				return 1;
+			}
+			previous = block[i];
+		}
+	}
+	close(input);
+
+	std::cout << file_name << ": " << value_count << " values, sorted" << std::endl;
+	return 0;
+}
+
+
+int main(int argc, char **argv) {
+	std::string mode = (argc > 1) ? argv[1] : "";
+
+	try {
+		if (mode == "generate" && argc == 4) {
+			generate(argv[2], std::strtoul(argv[3], nullptr, 10));
+			return 0;
+		}
+		if (mode == "check" && argc == 3) {
+			return check(argv[2]);
+		}
+		if (mode == "sort" && argc >= 4 && argc <= 6) {
+			std::string output = argv[3];
+			std::size_t memory = ((argc > 4) ? std::strtoul(argv[4], nullptr, 10) : 1024) << 20;
+			std::string directory = (argc > 5) ? argv[5] : output.substr(0, output.find_last_of('/') + 1) + ".";
+
+			external_sort_statistics statistics = external_sort<double>(argv[2], output, memory, directory);
+			double megabytes = statistics.values*sizeof(double)/1e6;
+			double seconds = statistics.run_seconds + statistics.merge_seconds;
+
+			std::cout << statistics.values << " values (" << megabytes << " MB), " << omp_get_max_threads() << " threads, "
+				<< (memory >> 20) << " MB memory" << std::endl;
+			std::cout << "runs:  " << statistics.runs << " runs in " << statistics.run_seconds << " s ("
+				<< statistics.run_bytes/1e6/statistics.run_seconds << " MB/s read + written)" << std::endl;
+			std::cout << "merge: " << statistics.merge_passes << " passes in " << statistics.merge_seconds << " s ("
+				<< statistics.merge_bytes/1e6/statistics.merge_seconds << " MB/s read + written)" << std::endl;
+			std::cout << "total: " << seconds << " s (" << megabytes/seconds << " MB/s sorted)" << std::endl;
+			return 0;
+		}
+	}
+	catch (std::exception & error) {
+		std::cerr << error.what() << std::endl;
+		return 1;
+	}
+
+	std::cerr << "Usage: ./external_sort generate file value_count" << std::endl;
+	std::cerr << "       ./external_sort sort input output [memory_MB] [temporary_directory]" << std::endl;
+	std::cerr << "       ./external_sort check file" << std::endl;
+	return 1;
+}
@@ -0,0 +1,336 @@
+/* FILE EXTERNAL_SORT.HPP */
+#ifndef FILE_EXTERNAL_SORT_HPP
+#define FILE_EXTERNAL_SORT_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "radix_sort.hpp"
+
+/*
+ * External merge sort for binary files of numeric values (any type of radix_sort.hpp) which do not fit into memory.
+ *
+ *	1. run generation: the input is read in chunks of a quarter of the memory budget, every chunk is sorted with
+ *	   parallel_radix_sort and written to a temporary file while the next chunk is read and sorted (the radix sort needs
+ *	   two more buffers of the chunk size)
+ *	2. merging: up to fan_in runs at a time are merged with a loser tree (log2(k) comparisons per value, the winner is
+ *	   replayed along one path) into the output, every run and the output get a buffer of equal size from the budget.
+ *	   If there are more runs than fit, groups of runs are merged into longer runs first.
+ *
+ * All file accesses are large sequential read/write calls (at least 1 MB, posix_fadvise SEQUENTIAL), the temporary files
+ * are removed as soon as they are merged. external_sort returns the time and the bytes moved in each phase.
+ */
+
+class external_sort_statistics {
+	public:
+		std::size_t values = 0, runs = 0, merge_passes = 0;
+		double run_seconds = 0, merge_seconds = 0;
+		// bytes read + written
+		double run_bytes = 0, merge_bytes = 0;
+};
+
+
+inline void external_sort_read(int descriptor, void * data, std::size_t bytes, const std::string & file_name) {
+	char * target = static_cast<char *>(data);
+	while (bytes > 0) {
+		ssize_t result = read(descriptor, target, bytes);
+		if (result < 0 && errno == EINTR) { continue; }
+		if (result <= 0) { throw std::runtime_error(file_name + ": cannot read file (" + std::strerror(errno) + ")"); }
+		target += result;
+		bytes -= result;
+	}
+}
+
+
+inline void external_sort_write(int descriptor, const void * data, std::size_t bytes, const std::string & file_name) {
+	const char * source = static_cast<const char *>(data);
+	while (bytes > 0) {
+		ssize_t result = write(descriptor, source, bytes);
+		if (result < 0 && errno == EINTR) { continue; }
+		if (result <= 0) { throw std::runtime_error(file_name + ": cannot write file (" + std::strerror(errno) + ")"); }
+		source += result;
+		bytes -= result;
+	}
+}
+
+
+inline int external_sort_open(const std::string & file_name, bool for_writing) {
+	int descriptor = for_writing ? open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644) : open(file_name.c_str(), O_RDONLY);
+	if (descriptor < 0) { throw std::runtime_error(file_name + ": cannot open file (" + std::strerror(errno) + ")"); }
+	posix_fadvise(descriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+	return descriptor;
+}
+
+
+template <class T>
+class loser_tree {
+	/*
+	 * Tournament tree over k sequences: the internal nodes 1 .. k-1 store the loser of the match at the node, node 0 the
+	 * overall winner, the leaf of sequence i is node k + i. After the winner's key changed only its path has to be replayed.
+	 * Exhausted sequences lose against everything, ties are won by the lower sequence (the merge is stable).
+	 */
+	public:
+		loser_tree (int k) : k(k), tree(k, 0), keys(k), exhausted(k, 1) {}
+
+		void set(int sequence, const T & key) { keys[sequence] = key; exhausted[sequence] = 0; }
+
+		void build() {
+			std::vector<int> winners (2*k);
+			for (int i=0; i<k; i++) { winners[k + i] = i; }
+			for (int node=k-1; node>=1; node--) {
+				int a = winners[2*node], b = winners[2*node + 1];
+				winners[node] = beats(a, b) ? a : b;
+				tree[node] = beats(a, b) ? b : a;
+			}
+			tree[0] = (k == 1) ? 0 : winners[1];
+		}
+
+		bool empty() const { return exhausted[tree[0]]; }
+		int winner() const { return tree[0]; }
+		const T & top() const { return keys[tree[0]]; }
+
+		// the winner gets the next key of its sequence (or is exhausted)
+		void replace(const T & key) { keys[tree[0]] = key; replay(); }
+		void remove() { exhausted[tree[0]] = 1; replay(); }
+
+	private:
+		int k;
+		std::vector<int> tree;
+		std::vector<T> keys;
+		std::vector<char> exhausted;
+
+		bool beats(int a, int b) const {
+			if (exhausted[a] | exhausted[b]) { return !exhausted[a] || (exhausted[b] && a < b); }
+			return keys[a] < keys[b] || (!(keys[b] < keys[a]) && a < b);
+		}
+
+		void replay() {
+			int current = tree[0];
+			for (int node=(k + current)/2; node>=1; node/=2) {
+				if (beats(tree[node], current)) { std::swap(tree[node], current); }
+			}
+			tree[0] = current;
+		}
+};
+
+
+template <class T>
+class external_run_reader {
+	// buffered sequential reader of one run (a range of a file)
+	public:
+		external_run_reader (const std::string & file_name, std::size_t count, std::size_t buffer_values) :
+				file_name(file_name), remaining(count), buffer(std::min(buffer_values, count)) {
+			descriptor = external_sort_open(file_name, false);
+		}
+
+		~external_run_reader() { close(descriptor); }
+
+		bool next(T & value) {
+			if (position == filled) {
+				if (remaining == 0) { return false; }
+				filled = std::min(remaining, buffer.size());
+				external_sort_read(descriptor, buffer.data(), filled*sizeof(T), file_name);
+				remaining -= filled;
+				position = 0;
+			}
+			value = buffer[position++];
+			return true;
+		}
+
+	private:
+		std::string file_name;
+		int descriptor;
+		std::size_t remaining, position = 0, filled = 0;
+		std::vector<T> buffer;
+};
+
+
+template <class T>
+void external_merge(const std::vector<std::string> & inputs, const std::vector<std::size_t> & counts,
+		const std::string & output_name, std::size_t buffer_values) {
+	/*
+	 * k-way merge of sorted files with a loser tree, all files are read and written in blocks of buffer_values values.
+	 * If reading or writing fails, the incomplete output is removed (the inputs are left to the caller).
+	 */
+	int k = inputs.size();
+	std::vector<std::unique_ptr<external_run_reader<T> > > readers;
+	for (int i=0; i<k; i++) { readers.emplace_back(new external_run_reader<T>(inputs[i], counts[i], buffer_values)); }
+
+	loser_tree<T> tree (k);
+	for (int i=0; i<k; i++) {
+		T value;
+		if (readers[i]->next(value)) { tree.set(i, value); }
+	}
+	tree.build();
+
+	int output = external_sort_open(output_name, true);
+	try {
+		std::vector<T> buffer (buffer_values);
+		std::size_t filled = 0;
+
+		while (!tree.empty()) {
+			buffer[filled++] = tree.top();
+			if (filled == buffer.size()) {
+				external_sort_write(output, buffer.data(), filled*sizeof(T), output_name);
+				filled = 0;
+			}
+
+			T value;
+			if (readers[tree.winner()]->next(value)) { tree.replace(value); }
+			else { tree.remove(); }
+		}
+
+		external_sort_write(output, buffer.data(), filled*sizeof(T), output_name);
+	}
+	catch (...) {
+		close(output);
+		unlink(output_name.c_str());
+		throw;
+	}
+	close(output);
+}
+
+
+template <class T>
+external_sort_statistics external_sort(const std::string & input_name, const std::string & output_name,
+		std::size_t memory_bytes, const std::string & temporary_directory) {
+	external_sort_statistics statistics;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	int input = external_sort_open(input_name, false);
+	struct stat information;
+	if (fstat(input, &information) != 0 || information.st_size % sizeof(T) != 0) {
+		close(input);
+		throw std::runtime_error(input_name + ": size is not a multiple of the value size");
+	}
+	statistics.values = information.st_size/sizeof(T);
+
+	// phase 1: sorted runs, the next chunk is read and sorted while the previous one is written
+	std::size_t chunk_values = std::max<std::size_t>(memory_bytes/4/sizeof(T), 1 << 16);
+	std::string prefix = temporary_directory + "/external_sort_" + std::to_string(getpid()) + "_";
+	std::vector<std::string> runs;
+	std::vector<std::size_t> run_counts;
+
+	std::vector<T> chunk, writing;
+	std::thread writer;
+	std::string write_error;
+
+	// a failed read, allocation or sort must not leave the writer running (std::terminate), the input open or runs behind
+	try {
+		for (std::size_t first=0; first<statistics.values; first+=chunk_values) {
+			std::size_t count = std::min(chunk_values, statistics.values - first);
+			chunk.resize(count);
+			external_sort_read(input, chunk.data(), count*sizeof(T), input_name);
+			parallel_radix_sort(chunk.data(), count);
+
+			if (writer.joinable()) { writer.join(); }
+			if (!write_error.empty()) { break; }
+			std::swap(chunk, writing);
+
+			std::string run_name = prefix + std::to_string(runs.size()) + ".run";
+			runs.push_back(run_name);
+			run_counts.push_back(count);
+			writer = std::thread([&writing, &write_error, run_name]() {
+				try {
+					int descriptor = external_sort_open(run_name, true);
+					external_sort_write(descriptor, writing.data(), writing.size()*sizeof(T), run_name);
+					close(descriptor);
+				}
+				catch (std::exception & error) { write_error = error.what(); }
+			});
+		}
+	}
+	catch (...) {
+		if (writer.joinable()) { writer.join(); }
+		close(input);
+		for (std::size_t i=0; i<runs.size(); i++) { unlink(runs[i].c_str()); }
+		throw;
+	}
+	if (writer.joinable()) { writer.join(); }
+	close(input);
+	std::vector<T>().swap(chunk);
+	std::vector<T>().swap(writing);
+
+	if (!write_error.empty()) {
+		for (std::size_t i=0; i<runs.size(); i++) { unlink(runs[i].c_str()); }
+		throw std::runtime_error(write_error);
+	}
+
+	statistics.runs = runs.size();
+	statistics.run_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	statistics.run_bytes = 2.0*statistics.values*sizeof(T);
+	start = std::chrono::steady_clock::now();
+
+	// phase 2: merge passes with at most fan_in runs of at least 1 MB buffer each (plus the output buffer)
+	// (at least 2 runs, so budgets below 3 MB use 3 MB; every run is an open file, some descriptors are left for the rest)
+	const std::size_t minimum_buffer_values = (1 << 20)/sizeof(T);
+	std::size_t fan_in = std::max<std::size_t>(memory_bytes/(minimum_buffer_values*sizeof(T)), 3) - 1;
+	struct rlimit files;
+	if (getrlimit(RLIMIT_NOFILE, &files) == 0 && files.rlim_cur != RLIM_INFINITY) {
+		fan_in = std::min<std::size_t>(fan_in, std::max<rlim_t>(files.rlim_cur, 18) - 16);
+	}
+
+	if (statistics.values == 0) {
+		close(external_sort_open(output_name, true));
+	}
+
+	// a single run only has to be moved (rename fails across file systems, then it is copied by the merge)
+	if (runs.size() == 1 && rename(runs[0].c_str(), output_name.c_str()) == 0) { runs.clear(); }
+
+	while (!runs.empty()) {
+		bool last_pass = runs.size() <= fan_in;
+		std::vector<std::string> merged_runs;
+		std::vector<std::size_t> merged_counts;
+
+		// on failure all temporary runs of this and the next pass are removed (those already merged are gone, unlink fails)
+		try {
+			for (std::size_t first=0; first<runs.size(); first+=fan_in) {
+				std::size_t end = std::min(first + fan_in, runs.size());
+				std::vector<std::string> group (runs.begin() + first, runs.begin() + end);
+				std::vector<std::size_t> group_counts (run_counts.begin() + first, run_counts.begin() + end);
+
+				std::string target = last_pass ? output_name : prefix + "m" + std::to_string(statistics.merge_passes) + "_"
+					+ std::to_string(merged_runs.size()) + ".run";
+				std::size_t buffer_values = std::max(memory_bytes/sizeof(T)/(group.size() + 1), minimum_buffer_values);
+				external_merge<T>(group, group_counts, target, buffer_values);
+
+				for (std::size_t i=0; i<group.size(); i++) { unlink(group[i].c_str()); }
+				std::size_t total = 0;
+				for (std::size_t i=0; i<group_counts.size(); i++) { total += group_counts[i]; }
+				merged_runs.push_back(target);
+				merged_counts.push_back(total);
+			}
+		}
+		catch (...) {
+			for (std::size_t i=0; i<runs.size(); i++) { unlink(runs[i].c_str()); }
+			for (std::size_t i=0; i<merged_runs.size(); i++) { unlink(merged_runs[i].c_str()); }
+			throw;
+		}
+
+		statistics.merge_passes++;
+		statistics.merge_bytes += 2.0*statistics.values*sizeof(T);
+		if (last_pass) { break; }
+		runs.swap(merged_runs);
+		run_counts.swap(merged_counts);
+	}
+
+	statistics.merge_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return statistics;
+}
+
+#endif /* FILE_EXTERNAL_SORT_HPP */
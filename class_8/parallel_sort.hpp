@@ -0,0 +1,117 @@
+/* FILE PARALLEL_SORT.HPP */
+#ifndef FILE_PARALLEL_SORT_HPP
+#define FILE_PARALLEL_SORT_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include <omp.h>
+
+/*
+ * Parallel sample sort with the interface of std::sort: parallel_sort(first, last) and parallel_sort(first, last, compare)
+ * for random access iterators and any strict weak ordering (e.g. the reverse lambda of sorting_solution.cpp).
+ *
+ *	1. a sorted random sample of the input yields b - 1 splitters, which divide the values into b buckets of similar size
+ *	2. every thread classifies a contiguous block of the input (binary search over the splitters) and counts the values
+ *	   per bucket, the prefix sums over (bucket, thread) give every thread its own output range in every bucket
+ *	3. every thread moves its values into a buffer at their bucket positions (no synchronisation needed)
+ *	4. the buckets are sorted independently (dynamic schedule, b is several times the number of threads) and moved back
+ *
+ * Values equal to a splitter go to an extra equality bucket which needs no sorting, so inputs with few distinct values
+ * do not end up in one huge bucket. Needs one buffer of n values and 2 bytes per value, falls back to std::sort for
+ * small inputs or a single thread. Like std::sort the sort is not stable.
+ *
+ * The buffer is uninitialized storage (the values are move constructed into it and destroyed after they are moved back),
+ * so like for std::sort the values only have to be move constructible and move assignable (and copy constructible
+ * for the sample).
+ */
+
+template <class iterator, class compare>
+void parallel_sort(iterator first, iterator last, compare less) {
+	typedef typename std::iterator_traits<iterator>::value_type value_type;
+
+	const std::size_t n = last - first;
+	const int threads = omp_get_max_threads();
+	if (n < (1 << 16) || threads == 1) {
+		std::sort(first, last, less);
+		return;
+	}
+
+	// sample with a fixed linear congruential sequence (reproducible), oversampling 32 values per bucket
+	const int splitter_buckets = std::min(8*threads, 128);
+	const int oversampling = 32;
+	std::vector<value_type> sample;
+	sample.reserve(splitter_buckets*oversampling);
+	std::uint64_t state = 1;
+	for (int i=0; i<splitter_buckets*oversampling; i++) {
+		state = state*6364136223846793005ull + 1442695040888963407ull;
+		sample.push_back(first[(state >> 33) % n]);
+	}
+	std::sort(sample.begin(), sample.end(), less);
+
+	std::vector<value_type> splitters;
+	for (int i=1; i<splitter_buckets; i++) {
+		const value_type & candidate = sample[i*oversampling];
+		if (splitters.empty() || less(splitters.back(), candidate)) { splitters.push_back(candidate); }
+	}
+
+	// bucket 2k: values between splitter k-1 and k, bucket 2k+1: values equal to splitter k
+	const int buckets = 2*splitters.size() + 1;
+	std::vector<std::uint16_t> bucket_of (n);
+	std::vector<std::size_t> offsets (threads*buckets + 1, 0);
+	std::allocator<value_type> allocator;
+	value_type * buffer = allocator.allocate(n);
+
+	#pragma omp parallel num_threads(threads)
+	{
+		int thread = omp_get_thread_num(), team = omp_get_num_threads();
+		std::size_t begin = n*thread/team, end = n*(thread + 1)/team;
+
+		// counts stored bucket-major, so that the exclusive prefix sum is the output position of (bucket, thread)
+		for (std::size_t i=begin; i<end; i++) {
+			const value_type & value = first[i];
+			int k = std::upper_bound(splitters.begin(), splitters.end(), value, less) - splitters.begin();
+			int bucket = (k > 0 && !less(splitters[k-1], value)) ? 2*k - 1 : 2*k;
+			bucket_of[i] = bucket;
+			offsets[bucket*threads + thread + 1]++;
+		}
+
+		#pragma omp barrier
+		#pragma omp single
+		for (std::size_t j=1; j<offsets.size(); j++) { offsets[j] += offsets[j-1]; }
+
+		for (std::size_t i=begin; i<end; i++) {
+			new (buffer + offsets[bucket_of[i]*threads + thread]++) value_type(std::move(first[i]));
+		}
+
+		#pragma omp barrier
+
+		// after the scatter offsets[bucket*threads + threads - 1] is the end of the bucket
+		#pragma omp for schedule(dynamic, 1)
+		for (int bucket=0; bucket<buckets; bucket++) {
+			std::size_t bucket_begin = (bucket == 0) ? 0 : offsets[bucket*threads - 1];
+			std::size_t bucket_end = offsets[bucket*threads + threads - 1];
+
+			if (bucket % 2 == 0) { std::sort(buffer + bucket_begin, buffer + bucket_end, less); }
+			std::move(buffer + bucket_begin, buffer + bucket_end, first + bucket_begin);
+			for (std::size_t i=bucket_begin; i<bucket_end; i++) { buffer[i].~value_type(); }
+		}
+	}
+
+	allocator.deallocate(buffer, n);
+}
+
+
+template <class iterator>
+void parallel_sort(iterator first, iterator last) {
+	parallel_sort(first, last, std::less<typename std::iterator_traits<iterator>::value_type>());
+}
+
+#endif /* FILE_PARALLEL_SORT_HPP */
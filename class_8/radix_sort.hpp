@@ -0,0 +1,340 @@
+/* FILE RADIX_SORT.HPP */
+#ifndef FILE_RADIX_SORT_HPP
+#define FILE_RADIX_SORT_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <omp.h>
+
+/*
+ * LSD radix sort for numeric keys (double, float, 32/64-bit signed and unsigned integers) in ascending order.
+ *
+ * The keys are first mapped to unsigned integers with the same order (radix_traits): for IEEE-754 values the sign bit is
+ * flipped for positive numbers and all bits are flipped for negative ones, for signed integers only the sign bit is
+ * flipped. These are sorted by 8-bit digits starting with the least significant one, every pass is a stable counting sort
+ * (histogram, prefix sum, scatter into a second buffer). The histograms of all digits are counted in one pass over the
+ * keys before sorting, 256 counters per digit fit into L1. Passes where all keys have the same digit are skipped, e.g. the
+ * exponent bytes of values from a narrow range.
+ *
+ *	radix_sort(keys, n)                  sorts the keys
+ *	radix_sort(keys, values, n)          sorts the keys and applies the same permutation to values (key-value mode)
+ *	radix_argsort(keys, n)               returns the indices which sort keys (keys are not changed), stable
+ *	parallel_radix_sort(keys, n)         OpenMP version: the first split uses per-thread histograms of contiguous blocks,
+ *	                                     the buckets are sorted in parallel
+ *
+ * Needs two buffers of n encoded keys (and two of n values in key-value mode). -0.0 sorts before +0.0,
+ * NaNs with the sign bit set before everything, the others after everything.
+ */
+
+template <class T> class radix_traits;
+
+template <> class radix_traits<std::uint32_t> {
+	public:
+		typedef std::uint32_t key_type;
+		static key_type encode(std::uint32_t value) { return value; }
+		static std::uint32_t decode(key_type key) { return key; }
+};
+
+template <> class radix_traits<std::uint64_t> {
+	public:
+		typedef std::uint64_t key_type;
+		static key_type encode(std::uint64_t value) { return value; }
+		static std::uint64_t decode(key_type key) { return key; }
+};
+
+template <> class radix_traits<std::int32_t> {
+	public:
+		typedef std::uint32_t key_type;
+		static key_type encode(std::int32_t value) { return (key_type) value ^ 0x80000000u; }
+		static std::int32_t decode(key_type key) { return (std::int32_t) (key ^ 0x80000000u); }
+};
+
+template <> class radix_traits<std::int64_t> {
+	public:
+		typedef std::uint64_t key_type;
+		static key_type encode(std::int64_t value) { return (key_type) value ^ 0x8000000000000000ull; }
+		static std::int64_t decode(key_type key) { return (std::int64_t) (key ^ 0x8000000000000000ull); }
+};
+
+template <> class radix_traits<float> {
+	public:
+		typedef std::uint32_t key_type;
+
+		static key_type encode(float value) {
+			key_type bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			// all bits for negative values (their order is reversed), only the sign bit for positive ones
+			key_type mask = -(bits >> 31) | 0x80000000u;
+			return bits ^ mask;
+		}
+
+		static float decode(key_type key) {
+			key_type mask = ((key >> 31) - 1) | 0x80000000u;
+			key_type bits = key ^ mask;
+			float value;
+			std::memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+};
+
+template <> class radix_traits<double> {
+	public:
+		typedef std::uint64_t key_type;
+
+		static key_type encode(double value) {
+			key_type bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			key_type mask = -(bits >> 63) | 0x8000000000000000ull;
+			return bits ^ mask;
+		}
+
+		static double decode(key_type key) {
+			key_type mask = ((key >> 63) - 1) | 0x8000000000000000ull;
+			key_type bits = key ^ mask;
+			double value;
+			std::memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+};
+
+
+// empty value type for the sorts without values
+class radix_no_value {};
+
+// buckets whose keys and buffers fit into this many bytes (about the L2 cache) are finished with LSD passes
+const std::size_t radix_cache_bytes = 1 << 20;
+
+
+template <class key_type>
+int radix_varying_bits(const key_type * keys, std::size_t n) {
+	/*
+	 * Number of low bits in which the keys differ (all higher bits are the same for all keys).
+	 */
+	key_type differences = 0;
+	for (std::size_t i=1; i<n; i++) { differences |= keys[i] ^ keys[0]; }
+
+	int bits = 0;
+	while (bits < (int) (8*sizeof(key_type)) && (differences >> bits) != 0) { bits++; }
+	return bits;
+}
+
+
+template <class key_type, class value_type>
+void radix_sort_lsd(key_type * keys, key_type * key_buffer, value_type * values, value_type * value_buffer, std::size_t n, int bits) {
+	/*
+	 * LSD passes over the 8-bit digits of the lowest bits, values may be nullptr. The result ends up in keys (and values).
+	 */
+	const int digits = (bits + 7)/8;
+	std::size_t counts[8][256] = {{0}};
+
+	for (std::size_t i=0; i<n; i++) {
+		key_type key = keys[i];
+		for (int d=0; d<digits; d++) { counts[d][(key >> 8*d) & 0xff]++; }
+	}
+
+	key_type * from = keys, * to = key_buffer;
+	value_type * values_from = values, * values_to = value_buffer;
+
+	for (int d=0; d<digits; d++) {
+		if (counts[d][(from[0] >> 8*d) & 0xff] == n) { continue; }
+
+		std::size_t offset[256];
+		std::size_t sum = 0;
+		for (int b=0; b<256; b++) { offset[b] = sum; sum += counts[d][b]; }
+
+		if (values == nullptr) {
+			for (std::size_t i=0; i<n; i++) { to[offset[(from[i] >> 8*d) & 0xff]++] = from[i]; }
+		}
+		else {
+			for (std::size_t i=0; i<n; i++) {
+				std::size_t target = offset[(from[i] >> 8*d) & 0xff]++;
+				to[target] = from[i];
+				values_to[target] = values_from[i];
+			}
+		}
+
+		std::swap(from, to);
+		std::swap(values_from, values_to);
+	}
+
+	if (from != keys) {
+		std::copy(from, from + n, keys);
+		if (values != nullptr) { std::copy(values_from, values_from + n, values); }
+	}
+}
+
+
+template <class key_type, class value_type>
+void radix_sort_encoded(key_type * keys, key_type * key_buffer, value_type * values, value_type * value_buffer, std::size_t n) {
+	/*
+	 * Serial sort of encoded keys, values may be nullptr. The result ends up in keys (and values).
+	 *
+	 * Every LSD pass over a large array scatters to 256 places all over memory, so large arrays are first split by the
+	 * most significant varying digit (one stable scatter pass into the buffer) until the buckets fit into the cache,
+	 * and the remaining LSD passes of every bucket run in the cache.
+	 */
+	if (n < 2) { return; }
+
+	int bits = radix_varying_bits(keys, n);
+	if (bits == 0) { return; }
+
+	std::size_t element_bytes = 2*(sizeof(key_type) + ((values == nullptr) ? 0 : sizeof(value_type)));
+	if (n*element_bytes <= radix_cache_bytes || bits <= 8) {
+		radix_sort_lsd(keys, key_buffer, values, value_buffer, n, bits);
+		return;
+	}
+
+	int shift = bits - 8;
+	std::size_t count[256] = {0}, offset[257];
+	for (std::size_t i=0; i<n; i++) { count[(keys[i] >> shift) & 0xff]++; }
+	offset[0] = 0;
+	for (int b=0; b<256; b++) { offset[b+1] = offset[b] + count[b]; }
+
+	std::size_t position[256];
+	std::copy(offset, offset + 256, position);
+	for (std::size_t i=0; i<n; i++) {
+		std::size_t target = position[(keys[i] >> shift) & 0xff]++;
+		key_buffer[target] = keys[i];
+		if (values != nullptr) { value_buffer[target] = values[i]; }
+	}
+
+	// the buckets are sorted in the buffer (with keys as scratch space) and copied back while they are still in the cache
+	for (int b=0; b<256; b++) {
+		std::size_t begin = offset[b], end = offset[b+1];
+		if (begin == end) { continue; }
+
+		if (values == nullptr) {
+			radix_sort_encoded<key_type, value_type>(key_buffer + begin, keys + begin, nullptr, nullptr, end - begin);
+		}
+		else {
+			radix_sort_encoded(key_buffer + begin, keys + begin, value_buffer + begin, values + begin, end - begin);
+			std::copy(value_buffer + begin, value_buffer + end, values + begin);
+		}
+		std::copy(key_buffer + begin, key_buffer + end, keys + begin);
+	}
+}
+
+
+template <class key_type>
+void parallel_radix_sort_encoded(key_type * keys, key_type * key_buffer, std::size_t n) {
+	/*
+	 * The first split by the most significant varying digit is done in parallel: each thread counts the digits of its
+	 * contiguous block, the prefix sums in the order (digit, thread) are the first output positions of every thread, then
+	 * every thread scatters its block (stable). The buckets are sorted independently with the serial sort.
+	 */
+	key_type differences = 0;
+
+	#pragma omp parallel for reduction(|:differences)
+	for (std::size_t i=1; i<n; i++) { differences |= keys[i] ^ keys[0]; }
+
+	int bits = 0;
+	while (bits < (int) (8*sizeof(key_type)) && (differences >> bits) != 0) { bits++; }
+	if (bits == 0) { return; }
+	int shift = (bits > 8) ? bits - 8 : 0;
+
+	const int threads = omp_get_max_threads();
+	std::vector<std::size_t> offsets (256*threads + 1);
+	std::size_t bucket_offset[257];
+
+	#pragma omp parallel num_threads(threads)
+	{
+		int thread = omp_get_thread_num(), team = omp_get_num_threads();
+		std::size_t begin = n*thread/team, end = n*(thread + 1)/team;
+
+		std::size_t count[256] = {0};
+		for (std::size_t i=begin; i<end; i++) { count[(keys[i] >> shift) & 0xff]++; }
+		for (int b=0; b<256; b++) { offsets[b*team + thread] = count[b]; }
+
+		#pragma omp barrier
+		#pragma omp single
+		{
+			std::size_t sum = 0;
+			for (int j=0; j<256*team; j++) {
+				if (j % team == 0) { bucket_offset[j/team] = sum; }
+				std::size_t current = offsets[j];
+				offsets[j] = sum;
+				sum += current;
+			}
+			bucket_offset[256] = sum;
+		}
+
+		std::size_t position[256];
+		for (int b=0; b<256; b++) { position[b] = offsets[b*team + thread]; }
+		for (std::size_t i=begin; i<end; i++) { key_buffer[position[(keys[i] >> shift) & 0xff]++] = keys[i]; }
+
+		#pragma omp barrier
+		#pragma omp for schedule(dynamic, 1)
+		for (int b=0; b<256; b++) {
+			std::size_t bucket_begin = bucket_offset[b], bucket_end = bucket_offset[b+1];
+			radix_sort_encoded<key_type, radix_no_value>(key_buffer + bucket_begin, keys + bucket_begin, nullptr, nullptr,
+				bucket_end - bucket_begin);
+			std::copy(key_buffer + bucket_begin, key_buffer + bucket_end, keys + bucket_begin);
+		}
+	}
+}
+
+
+template <class T>
+void radix_sort(T * keys, std::size_t n) {
+	typedef typename radix_traits<T>::key_type key_type;
+	std::vector<key_type> encoded (n), buffer (n);
+	for (std::size_t i=0; i<n; i++) { encoded[i] = radix_traits<T>::encode(keys[i]); }
+
+	radix_sort_encoded<key_type, radix_no_value>(encoded.data(), buffer.data(), nullptr, nullptr, n);
+
+	for (std::size_t i=0; i<n; i++) { keys[i] = radix_traits<T>::decode(encoded[i]); }
+}
+
+
+template <class T, class V>
+void radix_sort(T * keys, V * values, std::size_t n) {
+	typedef typename radix_traits<T>::key_type key_type;
+	std::vector<key_type> encoded (n), buffer (n);
+	std::vector<V> value_buffer (n);
+	for (std::size_t i=0; i<n; i++) { encoded[i] = radix_traits<T>::encode(keys[i]); }
+
+	radix_sort_encoded(encoded.data(), buffer.data(), values, value_buffer.data(), n);
+
+	for (std::size_t i=0; i<n; i++) { keys[i] = radix_traits<T>::decode(encoded[i]); }
+}
+
+
+template <class T>
+std::vector<std::size_t> radix_argsort(const T * keys, std::size_t n) {
+	typedef typename radix_traits<T>::key_type key_type;
+	std::vector<key_type> encoded (n), buffer (n);
+	std::vector<std::size_t> indices (n), index_buffer (n);
+	for (std::size_t i=0; i<n; i++) {
+		encoded[i] = radix_traits<T>::encode(keys[i]);
+		indices[i] = i;
+	}
+
+	radix_sort_encoded(encoded.data(), buffer.data(), indices.data(), index_buffer.data(), n);
+	return indices;
+}
+
+
+template <class T>
+void parallel_radix_sort(T * keys, std::size_t n) {
+	if (n < (1 << 16) || omp_get_max_threads() == 1) {
+		radix_sort(keys, n);
+		return;
+	}
+
+	typedef typename radix_traits<T>::key_type key_type;
+	std::vector<key_type> encoded (n), buffer (n);
+
+	#pragma omp parallel for
+	for (std::size_t i=0; i<n; i++) { encoded[i] = radix_traits<T>::encode(keys[i]); }
+
+	parallel_radix_sort_encoded(encoded.data(), buffer.data(), n);
+
+	#pragma omp parallel for
+	for (std::size_t i=0; i<n; i++) { keys[i] = radix_traits<T>::decode(encoded[i]); }
+}
+
+#endif /* FILE_RADIX_SORT_HPP */
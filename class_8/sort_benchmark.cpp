@@ -0,0 +1,90 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <execution>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <omp.h>
+
+#include "bulk_random.hpp"
+#include "parallel_sort.hpp"
+#include "radix_sort.hpp"
+
+/*
+ * Sorting times of std::sort, parallel_sort (parallel_sort.hpp) and std::sort with std::execution::par (TBB backend)
+ * for random doubles in [0, 1), ascending and with the reverse comparison of sorting_solution.cpp.
+ * The radix sorts of radix_sort.hpp (ascending only) and the argsorts (radix_argsort and std::sort of an index array
+ * with a comparator) are timed as well.
+ *
+ * Usage: ./sort_benchmark value_count   (default 10^7)
+ *
+ * The number of threads is taken from OMP_NUM_THREADS, TBB uses all cores.
+ */
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+template <class sort_function, class compare>
+static void run(const std::string & name, const std::vector<double> & values, sort_function sort, compare less) {
+	// sorts a copy, checks the result
+	std::vector<double> to_sort = values;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	sort(to_sort, less);
+	double seconds = seconds_since(start);
+
+	bool sorted = std::is_sorted(to_sort.begin(), to_sort.end(), less);
+	std::cout << "\t" << name << ": " << seconds << " s (" << values.size()/seconds*1e-6 << " million values/s)"
+		<< (sorted ? "" : " NOT SORTED") << std::endl;
+}
+
+
+template <class compare>
+static void compare_sorts(const std::vector<double> & values, compare less) {
+	run("std::sort", values, [](std::vector<double> & v, compare l) { std::sort(v.begin(), v.end(), l); }, less);
+	run("parallel_sort", values, [](std::vector<double> & v, compare l) { parallel_sort(v.begin(), v.end(), l); }, less);
+	run("std::sort(std::execution::par)", values,
+		[](std::vector<double> & v, compare l) { std::sort(std::execution::par, v.begin(), v.end(), l); }, less);
+}
+
+
+int main(int argc, char **argv) {
+	std::size_t value_count = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+	std::cout << value_count << " values, " << omp_get_max_threads() << " OpenMP threads" << std::endl;
+
+	std::vector<double> values (value_count);
+	fill_uniform(values.data(), value_count, 1);
+
+	std::cout << "ascending:" << std::endl;
+	compare_sorts(values, std::less<double>());
+
+	run("radix_sort", values, [](std::vector<double> & v, std::less<double>) { radix_sort(v.data(), v.size()); }, std::less<double>());
+	run("parallel_radix_sort", values, [](std::vector<double> & v, std::less<double>) { parallel_radix_sort(v.data(), v.size()); },
+		std::less<double>());
+
+	std::cout << "argsort:" << std::endl;
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		std::vector<std::size_t> indices (value_count);
+		for (std::size_t i=0; i<value_count; i++) { indices[i] = i; }
+		std::sort(indices.begin(), indices.end(), [&](std::size_t i, std::size_t j) { return values[i] < values[j]; });
+		std::cout << "\tstd::sort (indices): " << seconds_since(start) << " s" << std::endl;
+
+		start = std::chrono::steady_clock::now();
+		std::vector<std::size_t> radix_indices = radix_argsort(values.data(), value_count);
+		double seconds = seconds_since(start);
+		bool sorted = true;
+		for (std::size_t i=1; i<value_count; i++) { sorted &= values[radix_indices[i-1]] <= values[radix_indices[i]]; }
+		std::cout << "\tradix_argsort: " << seconds << " s" << (sorted ? "" : " NOT SORTED") << std::endl;
+	}
+
+	std::cout << "reverse (lambda):" << std::endl;
+	compare_sorts(values, [](double i, double j) { return (i > j); });
+
+	return 0;
+}
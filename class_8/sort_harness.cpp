@@ -0,0 +1,231 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <omp.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "bulk_random.hpp"
+#include "parallel_sort.hpp"
+#include "radix_sort.hpp"
+
+/*
+ * Benchmark harness for the sorts of class_8, writes one CSV line per (type, comparator, distribution, size, algorithm):
+ *
+ *	type,comparator,distribution,size,algorithm,threads,repetitions,seconds,million_elements_per_second,cycles_per_element
+ *
+ * seconds is the median over the repetitions (small sizes are repeated until 0.2 s are spent, at least 3 times, every
+ * repetition sorts a fresh copy of the input), cycles_per_element is measured with the time stamp counter (reference
+ * cycles at the nominal frequency, 0 on other architectures).
+ *
+ * distributions (the keys are doubles in [0, 1)):
+ *	uniform         independent uniform keys
+ *	sorted          the uniform keys in ascending order
+ *	reverse         the uniform keys in descending order
+ *	few_unique      16 distinct keys
+ *	zipf            Zipf distributed ranks (exponent 1) over min(size, 2^20) distinct keys, rank 0 is the most frequent
+ *	nearly_sorted   sorted, then size/100 random pairs swapped
+ *
+ * types:
+ *	double   the key                             std::sort, std::stable_sort, parallel_sort, radix_sort
+ *	int64    the key scaled to [0, 2^53)         std::sort, std::stable_sort, parallel_sort, radix_sort
+ *	vec3     key * random unit vector (24 bytes) std::sort, std::stable_sort, parallel_sort with the comparators
+ *	         norm (squared length, the order of the keys) and lexicographic (x, y, z; unrelated to the distribution)
+ *
+ * Usage: ./sort_harness [max_size [min_size]]   (decades from min_size = 10^3 to max_size = 10^9)
+ *
+ * Sizes which would need more than 3/4 of the physical memory are skipped (with a note on stderr), the number of threads of
+ * parallel_sort is taken from OMP_NUM_THREADS. All inputs are generated from fixed seeds.
+ */
+
+class vec3 {
+	public:
+		double x, y, z;
+};
+
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+static std::uint64_t cycle_counter() {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+
+static std::vector<double> generate_keys(const std::string & distribution, std::size_t n) {
+	std::vector<double> keys (n);
+	fill_uniform(keys.data(), n, 1);
+
+	if (distribution == "sorted") {
+		std::sort(keys.begin(), keys.end());
+	}
+	else if (distribution == "reverse") {
+		std::sort(keys.begin(), keys.end(), [](double a, double b) { return a > b; });
+	}
+	else if (distribution == "few_unique") {
+		for (std::size_t i=0; i<n; i++) { keys[i] = std::floor(16.*keys[i])/16.; }
+	}
+	else if (distribution == "zipf") {
+		// inverse of the cumulative distribution by binary search
+		std::size_t distinct = std::min<std::size_t>(n, 1 << 20);
+		std::vector<double> cumulative (distinct);
+		double sum = 0;
+		for (std::size_t rank=0; rank<distinct; rank++) {
+			sum += 1./(rank + 1);
+			cumulative[rank] = sum;
+		}
+		for (std::size_t i=0; i<n; i++) {
+			std::size_t rank = std::upper_bound(cumulative.begin(), cumulative.end(), keys[i]*sum) - cumulative.begin();
+			keys[i] = (double) std::min(rank, distinct - 1)/distinct;
+		}
+	}
+	else if (distribution == "nearly_sorted") {
+		std::sort(keys.begin(), keys.end());
+		std::vector<std::uint64_t> positions (2*(n/100));
+		fill_random_bits(positions.data(), positions.size(), 2);
+		for (std::size_t i=0; i<positions.size(); i+=2) { std::swap(keys[positions[i] % n], keys[positions[i+1] % n]); }
+	}
+
+	return keys;
+}
+
+
+static void convert(const std::vector<double> & keys, std::vector<double> & values) { values = keys; }
+
+
+static void convert(const std::vector<double> & keys, std::vector<std::int64_t> & values) {
+	values.resize(keys.size());
+	for (std::size_t i=0; i<keys.size(); i++) { values[i] = (std::int64_t) (keys[i]*9007199254740992.); }
+}
+
+
+static void convert(const std::vector<double> & keys, std::vector<vec3> & values) {
+	std::vector<double> directions (3*keys.size());
+	fill_normal(directions.data(), directions.size(), 3);
+
+	values.resize(keys.size());
+	for (std::size_t i=0; i<keys.size(); i++) {
+		const double * d = &directions[3*i];
+		double scale = keys[i]/std::sqrt(d[0]*d[0] + d[1]*d[1] + d[2]*d[2]);
+		values[i].x = scale*d[0];
+		values[i].y = scale*d[1];
+		values[i].z = scale*d[2];
+	}
+}
+
+
+template <class T, class compare, class sort_function>
+static void measure(const std::string & type, const std::string & comparator, const std::string & distribution,
+		const std::string & algorithm, const std::vector<T> & input, compare less, sort_function sort) {
+	/*
+	 * Sorts copies of the input until at least 0.2 s (and 3 repetitions) are spent, prints the median time.
+	 */
+	std::vector<T> values;
+	std::vector<double> seconds;
+	std::vector<double> cycles;
+	double total = 0;
+
+	while (seconds.size() < 3 || (total < 0.2 && seconds.size() < 10000)) {
+		values = input;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		std::uint64_t first_cycle = cycle_counter();
+		sort(values, less);
+		cycles.push_back(cycle_counter() - first_cycle);
+		seconds.push_back(seconds_since(start));
+		total += seconds.back();
+
+		if (!std::is_sorted(values.begin(), values.end(), less)) {
+			throw std::runtime_error(algorithm + " did not sort " + type + " " + distribution);
+		}
+		// a single large sort is enough
+		if (seconds.size() == 1 && total > 1.) { break; }
+	}
+
+	std::size_t middle = seconds.size()/2;
+	std::nth_element(seconds.begin(), seconds.begin() + middle, seconds.end());
+	std::nth_element(cycles.begin(), cycles.begin() + middle, cycles.end());
+
+	std::size_t n = input.size();
+	std::cout << type << "," << comparator << "," << distribution << "," << n << "," << algorithm << "," << omp_get_max_threads()
+		<< "," << seconds.size() << "," << seconds[middle] << "," << n/seconds[middle]*1e-6 << "," << cycles[middle]/n << std::endl;
+}
+
+
+template <class T, class compare>
+static void comparison_sorts(const std::string & type, const std::string & comparator, const std::string & distribution,
+		const std::vector<T> & input, compare less) {
+	measure(type, comparator, distribution, "std::sort", input, less,
+		[](std::vector<T> & v, compare l) { std::sort(v.begin(), v.end(), l); });
+	measure(type, comparator, distribution, "std::stable_sort", input, less,
+		[](std::vector<T> & v, compare l) { std::stable_sort(v.begin(), v.end(), l); });
+	measure(type, comparator, distribution, "parallel_sort", input, less,
+		[](std::vector<T> & v, compare l) { parallel_sort(v.begin(), v.end(), l); });
+}
+
+
+template <class T>
+static void numeric_sorts(const std::string & type, const std::string & distribution, const std::vector<double> & keys) {
+	std::vector<T> input;
+	convert(keys, input);
+	comparison_sorts(type, "less", distribution, input, std::less<T>());
+	measure(type, "less", distribution, "radix_sort", input, std::less<T>(),
+		[](std::vector<T> & v, std::less<T>) { radix_sort(v.data(), v.size()); });
+}
+
+
+int main(int argc, char **argv) {
+	std::size_t max_size = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 1000000000;
+	std::size_t min_size = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 1000;
+
+	// input, copy and one buffer of the largest type plus the keys
+	double memory = (double) sysconf(_SC_PHYS_PAGES)*sysconf(_SC_PAGE_SIZE);
+	const std::size_t bytes_per_element = 3*sizeof(vec3) + sizeof(double);
+
+	const char * distributions[] = { "uniform", "sorted", "reverse", "few_unique", "zipf", "nearly_sorted" };
+
+	std::cout << "type,comparator,distribution,size,algorithm,threads,repetitions,seconds,million_elements_per_second,cycles_per_element"
+		<< std::endl;
+
+	for (std::size_t n=min_size; n<=max_size; n*=10) {
+		if (n*(double) bytes_per_element > .75*memory) {
+			std::cerr << "skipping " << n << " elements (" << n*(double) bytes_per_element*1e-9 << " GB needed, "
+				<< memory*1e-9 << " GB of memory)" << std::endl;
+			break;
+		}
+
+		for (const char * distribution : distributions) {
+			std::vector<double> keys = generate_keys(distribution, n);
+
+			numeric_sorts<double>("double", distribution, keys);
+			numeric_sorts<std::int64_t>("int64", distribution, keys);
+
+			std::vector<vec3> vectors;
+			convert(keys, vectors);
+			comparison_sorts("vec3", "norm", distribution, vectors, [](const vec3 & a, const vec3 & b) {
+				return a.x*a.x + a.y*a.y + a.z*a.z < b.x*b.x + b.y*b.y + b.z*b.z;
+			});
+			comparison_sorts("vec3", "lexicographic", distribution, vectors, [](const vec3 & a, const vec3 & b) {
+				return a.x < b.x || (a.x == b.x && (a.y < b.y || (a.y == b.y && a.z < b.z)));
+			});
+		}
+	}
+
+	return 0;
+}
@@ -1,22 +1,19 @@
 #include <iostream>
 #include <algorithm>
 #include <vector>
-#include <random>
 #include <sstream>
 
+#include "bulk_random.hpp"
 
-std::vector<double> create_array_of_random_values(int value_count) {
+
+std::vector<double> create_array_of_random_values(int value_count, std::uint64_t seed = 42) {
 	/*
 	 * This function creates a std::vector and fills it with value_count random values between 0 and 1.
+	 * The same seed gives the same values.
 	 */
 
-	std::random_device rd;
-	std::vector<double> random_values;
-
-	for (int i=0; i<value_count; i++) {
-		double current_value = rd()/(double)rd.max();
-		random_values.push_back(current_value);
-	}
+	std::vector<double> random_values (value_count);
+	fill_uniform(random_values.data(), value_count, seed);
 
 	return random_values;
 }
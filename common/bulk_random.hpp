@@ -0,0 +1,318 @@
+/* FILE BULK_RANDOM.HPP */
+#ifndef FILE_BULK_RANDOM_HPP
+#define FILE_BULK_RANDOM_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/*
+ * Random numbers for generating input data, shared by the exercises (compile with -I../common -fopenmp).
+ *
+ *	splitmix64(state)          expands a single 64 bit seed into well mixed words (used for all seeding)
+ *	xoshiro256                 xoshiro256** (Blackman & Vigna 2018), a small and fast generator with jump() = 2^128 steps
+ *	                           ahead, i.e. non-overlapping streams; usable with the distributions of <random>
+ *	counter_rng                Philox4x32-10, counter based: the numbers are a pure function of (seed, index, draw)
+ *
+ *	fill_random_bits(values, n, seed)                  32 or 64 random bits per value
+ *	fill_uniform(values, n, seed, lower, upper)        doubles in [lower, upper)
+ *	fill_normal(values, n, seed, mean, sigma)          normally distributed doubles (Box-Muller)
+ *
+ * The fills divide the array into blocks of bulk_random_block values, every block is generated by bulk_random_lanes
+ * interleaved xoshiro256** streams (lane l of block b is seeded with stream_seed(seed, b*lanes + l), independent seeds expanded
+ * by splitmix64 as recommended by Blackman & Vigna; this costs about 0.1 us per block, 8 jumps would cost about 7 us and
+ * dominate fills of a few thousand values). The lanes are stepped together in a structure of arrays, so the loop over the
+ * lanes is vectorised, and the blocks are filled in parallel with OpenMP. The result only depends on the seed, not on the
+ * number of threads, and the first values do not depend on n. The uniform transform puts 52 random bits into
+ * the mantissa of a double in [1, 2) (no integer to floating point conversion).
+ */
+
+inline std::uint64_t splitmix64(std::uint64_t & state) {
+	std::uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+
+// a well mixed seed for stream number stream of a seed (distinct streams of one seed get distinct seeds)
+inline std::uint64_t stream_seed(std::uint64_t seed, std::uint64_t stream) {
+	std::uint64_t state = seed ^ (stream*0xd1b54a32d192ed03ull);
+	return splitmix64(state);
+}
+
+
+inline std::uint64_t rotate_left(std::uint64_t x, int k) {
+	return (x << k) | (x >> (64 - k));
+}
+
+
+// 52 random bits to a double in [0, 1)
+inline double bits_to_uniform(std::uint64_t bits) {
+	std::uint64_t mantissa = (0x3ffull << 52) | (bits >> 12);
+	double value;
+	std::memcpy(&value, &mantissa, sizeof(value));
+	return value - 1.;
+}
+
+
+class xoshiro256 {
+	public:
+		typedef std::uint64_t result_type;
+
+		explicit xoshiro256 (std::uint64_t seed) {
+			std::uint64_t state = seed;
+			for (int i=0; i<4; i++) { s[i] = splitmix64(state); }
+		}
+
+		static constexpr result_type min() { return 0; }
+		static constexpr result_type max() { return ~(result_type) 0; }
+
+		result_type operator() () {
+			std::uint64_t result = rotate_left(s[1]*5, 7)*9;
+			std::uint64_t t = s[1] << 17;
+			s[2] ^= s[0];
+			s[3] ^= s[1];
+			s[1] ^= s[2];
+			s[0] ^= s[3];
+			s[2] ^= t;
+			s[3] = rotate_left(s[3], 45);
+			return result;
+		}
+
+		double uniform() { return bits_to_uniform((*this)()); }
+
+		// 2^128 and 2^192 steps ahead
+		void jump() {
+			static const std::uint64_t polynomial[4] = { 0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull, 0xa9582618e03fc9aaull, 0x39abdc4529b1661cull };
+			advance(polynomial);
+		}
+
+		void long_jump() {
+			static const std::uint64_t polynomial[4] = { 0x76e15d3efefdcbbfull, 0xc5004e441c522fb3ull, 0x77710069854ee241ull, 0x39109bb02acbe635ull };
+			advance(polynomial);
+		}
+
+		const std::uint64_t * state() const { return s; }
+
+	private:
+		std::uint64_t s[4];
+
+		void advance(const std::uint64_t polynomial[4]) {
+			std::uint64_t t[4] = {0, 0, 0, 0};
+			for (int i=0; i<4; i++) {
+				for (int bit=0; bit<64; bit++) {
+					if (polynomial[i] & ((std::uint64_t) 1 << bit)) {
+						for (int j=0; j<4; j++) { t[j] ^= s[j]; }
+					}
+					(*this)();
+				}
+			}
+			for (int j=0; j<4; j++) { s[j] = t[j]; }
+		}
+};
+
+
+const std::size_t bulk_random_block = 1 << 18;
+const int bulk_random_lanes = 8;
+
+
+class xoshiro256_lanes {
+	// bulk_random_lanes xoshiro256** generators stepped together, the state is stored lane-wise
+	public:
+		// the lanes of block number block of the fills with this seed
+		explicit xoshiro256_lanes (std::uint64_t seed, std::uint64_t block = 0) {
+			for (int l=0; l<bulk_random_lanes; l++) {
+				xoshiro256 lane (stream_seed(seed, block*bulk_random_lanes + l));
+				for (int j=0; j<4; j++) { s[j][l] = lane.state()[j]; }
+			}
+		}
+
+		// groups*bulk_random_lanes values, value g*lanes + l comes from lane l
+		void fill(std::uint64_t * values, std::size_t groups) {
+			for (std::size_t g=0; g<groups; g++) {
+				std::uint64_t * out = values + g*bulk_random_lanes;
+				for (int l=0; l<bulk_random_lanes; l++) {
+					out[l] = rotate_left(s[1][l]*5, 7)*9;
+					std::uint64_t t = s[1][l] << 17;
+					s[2][l] ^= s[0][l];
+					s[3][l] ^= s[1][l];
+					s[1][l] ^= s[2][l];
+					s[0][l] ^= s[3][l];
+					s[2][l] ^= t;
+					s[3][l] = rotate_left(s[3][l], 45);
+				}
+			}
+		}
+
+	private:
+		std::uint64_t s[4][bulk_random_lanes];
+};
+
+
+template <class transform>
+void bulk_random_fill(std::size_t n, std::uint64_t seed, transform apply) {
+	/*
+	 * Calls apply(first, count, bits) for consecutive chunks of [0, n) with at least count random words in bits
+	 * (rounded up to the lanes). The chunks of one block are small enough to stay in L1.
+	 */
+	const std::size_t chunk = 4096;
+	std::size_t blocks = (n + bulk_random_block - 1)/bulk_random_block;
+
+	// a single block needs no team (no worker threads in small programs like class_11/leak_simple.cpp)
+	#pragma omp parallel if(blocks > 1)
+	{
+		std::vector<std::uint64_t> bits (std::min(chunk, (n + bulk_random_lanes - 1)/bulk_random_lanes*bulk_random_lanes));
+
+		#pragma omp for schedule(static)
+		for (std::size_t b=0; b<blocks; b++) {
+			xoshiro256_lanes stream (seed, b);
+			std::size_t block_end = std::min(n, (b + 1)*bulk_random_block);
+			for (std::size_t first=b*bulk_random_block; first<block_end; first+=chunk) {
+				std::size_t count = std::min(chunk, block_end - first);
+				stream.fill(bits.data(), (count + bulk_random_lanes - 1)/bulk_random_lanes);
+				apply(first, count, bits.data());
+			}
+		}
+	}
+}
+
+
+inline void fill_random_bits(std::uint64_t * values, std::size_t n, std::uint64_t seed) {
+	bulk_random_fill(n, seed, [=](std::size_t first, std::size_t count, const std::uint64_t * bits) {
+		std::copy(bits, bits + count, values + first);
+	});
+}
+
+
+inline void fill_random_bits(std::uint32_t * values, std::size_t n, std::uint64_t seed) {
+	// the upper half of every word (the lowest bits of xoshiro256** are the weakest)
+	bulk_random_fill(n, seed, [=](std::size_t first, std::size_t count, const std::uint64_t * bits) {
+		for (std::size_t i=0; i<count; i++) { values[first + i] = bits[i] >> 32; }
+	});
+}
+
+
+inline void fill_uniform(double * values, std::size_t n, std::uint64_t seed, double lower = 0., double upper = 1.) {
+	double width = upper - lower;
+	bulk_random_fill(n, seed, [=](std::size_t first, std::size_t count, const std::uint64_t * bits) {
+		for (std::size_t i=0; i<count; i++) { values[first + i] = lower + width*bits_to_uniform(bits[i]); }
+	});
+}
+
+
+inline void fill_normal(double * values, std::size_t n, std::uint64_t seed, double mean = 0., double sigma = 1.) {
+	/*
+	 * Box-Muller: the words 2i and 2i+1 give the values 2i and 2i+1 (the chunks have an even size), 1 - u avoids log(0).
+	 */
+	const double two_pi = 6.283185307179586;
+	bulk_random_fill(n, seed, [=](std::size_t first, std::size_t count, const std::uint64_t * bits) {
+		double * out = values + first;
+		std::size_t pairs = count/2;
+		for (std::size_t i=0; i<pairs; i++) {
+			double radius = sigma*std::sqrt(-2.*std::log(1. - bits_to_uniform(bits[2*i])));
+			double angle = two_pi*bits_to_uniform(bits[2*i + 1]);
+			out[2*i] = mean + radius*std::cos(angle);
+			out[2*i + 1] = mean + radius*std::sin(angle);
+		}
+		if (count % 2 == 1) {
+			double radius = sigma*std::sqrt(-2.*std::log(1. - bits_to_uniform(bits[count - 1])));
+			out[count - 1] = mean + radius*std::cos(two_pi*bits_to_uniform(bits[count]));
+		}
+	});
+}
+
+
+/*
+ * Counter-based pseudo random number generator (Philox4x32-10, Salmon et al. 2011).
+ *
+ * A counter-based generator has no state that has to be advanced: the random numbers are a pure function of a key (the seed)
+ * and a counter. Thereby every body can use its own index as part of the counter and the results do not depend on the number
+ * of threads or on the order in which the bodies are generated.
+ *
+ * usage:
+ *	counter_rng rng (seed);
+ *	counter_rng::sequence random = rng.sequence_for(i);	// the random numbers of object i
+ *	double u = random.uniform();	// in [0, 1)
+ *	double g = random.normal();	// standard normal distribution
+ */
+class counter_rng {
+	public:
+		explicit counter_rng(std::uint64_t seed) : key0(seed & 0xFFFFFFFFu), key1(seed >> 32) { }
+
+		// four random 32 bit numbers for the given 128 bit counter
+		void block(const std::uint32_t counter[4], std::uint32_t result[4]) const {
+			std::uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+			std::uint32_t k0 = key0, k1 = key1;
+
+			for (int round=0; round<10; round++) {
+				std::uint64_t product0 = (std::uint64_t) 0xD2511F53u * c0;
+				std::uint64_t product1 = (std::uint64_t) 0xCD9E8D57u * c2;
+
+				std::uint32_t new_c0 = (std::uint32_t) (product1 >> 32) ^ c1 ^ k0;
+				std::uint32_t new_c2 = (std::uint32_t) (product0 >> 32) ^ c3 ^ k1;
+				c1 = (std::uint32_t) product1;
+				c3 = (std::uint32_t) product0;
+				c0 = new_c0;
+				c2 = new_c2;
+
+				k0 += 0x9E3779B9u;
+				k1 += 0xBB67AE85u;
+			}
+
+			result[0] = c0; result[1] = c1; result[2] = c2; result[3] = c3;
+		}
+
+		/*
+		 * The random numbers belonging to a single index (e.g. a body), every call to uniform() or normal() advances the
+		 * second half of the counter.
+		 */
+		class sequence {
+			public:
+				sequence(const counter_rng & rng, std::uint64_t index) : rng(rng), index(index) { }
+
+				double uniform() {
+					if (buffered == 0) { refill(); }
+					buffered--;
+					return values[buffered];
+				}
+
+				double uniform(double lower, double upper) { return lower + (upper - lower)*uniform(); }
+
+				double normal() {
+					// Box-Muller transform, 1 - u avoids log(0)
+					const double two_pi = 6.283185307179586;
+					double radius = std::sqrt(-2.*std::log(1. - uniform()));
+					return radius * std::cos(two_pi*uniform());
+				}
+
+			private:
+				const counter_rng & rng;
+				std::uint64_t index;
+				std::uint64_t draw = 0;
+				double values[2];
+				int buffered = 0;
+
+				void refill() {
+					std::uint32_t counter[4] = { (std::uint32_t) index, (std::uint32_t) (index >> 32), (std::uint32_t) draw, (std::uint32_t) (draw >> 32) };
+					std::uint32_t bits[4];
+					rng.block(counter, bits);
+					draw++;
+
+					// 53 random bits for each double in [0, 1)
+					values[0] = ((((std::uint64_t) bits[0] << 32) | bits[1]) >> 11) / 9007199254740992.;
+					values[1] = ((((std::uint64_t) bits[2] << 32) | bits[3]) >> 11) / 9007199254740992.;
+					buffered = 2;
+				}
+		};
+
+		sequence sequence_for(std::uint64_t index) const { return sequence(*this, index); }
+
+	private:
+		std::uint32_t key0, key1;
+};
+
+#endif /* FILE_BULK_RANDOM_HPP */
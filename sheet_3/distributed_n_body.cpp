@@ -0,0 +1,387 @@
+#include "distributed_n_body.hpp"
+#include "gravity_kernel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+
+static double coordinate(const cartesian_vector & position, int axis) {
+	return (axis == 0) ? position.x : ((axis == 1) ? position.y : position.z);
+}
+
+
+domain_decomposition::domain_decomposition (MPI_Comm communicator, double opening_angle)
+	: opening_angle(opening_angle), communicator(communicator) {
+
+	MPI_Comm_rank(communicator, &process_rank);
+	MPI_Comm_size(communicator, &process_count);
+}
+
+
+int domain_decomposition::owner(const cartesian_vector & position) const {
+	return std::upper_bound(boundaries.begin(), boundaries.end(), coordinate(position, axis)) - boundaries.begin();
+}
+
+
+void domain_decomposition::choose_boundaries(std::vector<double> coordinates, const std::vector<double> & weights) {
+	/*
+	 * Places the process_count - 1 slab boundaries at the quantiles of the weighted coordinates.
+	 */
+	std::vector<unsigned int> order (coordinates.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) { return coordinates[a] < coordinates[b]; });
+
+	double total_weight = std::accumulate(weights.begin(), weights.end(), 0.);
+	double cumulative = 0.;
+	unsigned int next = 0;
+
+	boundaries.assign(process_count - 1, std::numeric_limits<double>::max());
+	for (int p=0; p<process_count-1; p++) {
+		double target = total_weight*(p + 1)/process_count;
+		while (next < order.size() && cumulative + weights[order[next]] <= target) { cumulative += weights[order[next++]]; }
+
+		// the boundary lies between the last coordinate below the quantile and the next one
+		if (next < order.size()) {
+			boundaries[p] = (next == 0) ? coordinates[order[0]] : .5*(coordinates[order[next-1]] + coordinates[order[next]]);
+		}
+	}
+}
+
+
+void domain_decomposition::decompose(std::vector<body> & bodies) {
+	/*
+	 * All processes hold the same initial list, so the boundaries can be computed without communication.
+	 */
+	int n = bodies.size();
+
+	// slab axis along the largest extent of the system
+	double extent[3];
+	for (int a=0; a<3; a++) {
+		double low = std::numeric_limits<double>::max(), high = -low;
+		for (int i=0; i<n; i++) {
+			low = std::min(low, coordinate(bodies[i].position, a));
+			high = std::max(high, coordinate(bodies[i].position, a));
+		}
+		extent[a] = high - low;
+	}
+	axis = std::max_element(extent, extent + 3) - extent;
+
+	std::vector<double> coordinates (n);
+	for (int i=0; i<n; i++) { coordinates[i] = coordinate(bodies[i].position, axis); }
+	choose_boundaries(coordinates, std::vector<double>(n, 1.));
+
+	std::vector<body> local;
+	identifier.clear();
+	for (int i=0; i<n; i++) {
+		if (owner(bodies[i].position) == process_rank) {
+			local.push_back(bodies[i]);
+			identifier.push_back(i);
+		}
+	}
+
+	bodies.swap(local);
+	is_decomposed = true;
+}
+
+
+void domain_decomposition::accelerations(const std::vector<body> & bodies, std::vector<cartesian_vector> & acceleration, std::vector<double> * potential) {
+
+	double start = MPI_Wtime();
+	const int n = bodies.size();
+
+	// split the local bodies recursively at the median of the widest extent, until at most leaf_size bodies are left in a cell
+	const double largest = std::numeric_limits<double>::max();
+	std::vector<int> members (n), cell_start;
+	std::iota(members.begin(), members.end(), 0);
+
+	std::vector<std::pair<int, int> > pending;
+	if (n > 0) { pending.push_back(std::make_pair(0, n)); }
+	while (!pending.empty()) {
+		int first = pending.back().first, last = pending.back().second;
+		pending.pop_back();
+
+		if (last - first <= leaf_size) { cell_start.push_back(first); continue; }
+
+		double extent[3];
+		for (int a=0; a<3; a++) {
+			double low = largest, high = -largest;
+			for (int m=first; m<last; m++) {
+				low = std::min(low, coordinate(bodies[members[m]].position, a));
+				high = std::max(high, coordinate(bodies[members[m]].position, a));
+			}
+			extent[a] = high - low;
+		}
+		int split_axis = std::max_element(extent, extent + 3) - extent, middle = (first + last)/2;
+
+		std::nth_element(members.begin() + first, members.begin() + middle, members.begin() + last, [&](int i, int j) {
+			return coordinate(bodies[i].position, split_axis) < coordinate(bodies[j].position, split_axis);
+		});
+		pending.push_back(std::make_pair(middle, last));
+		pending.push_back(std::make_pair(first, middle));
+	}
+	cell_start.push_back(n);
+	const int cell_count = cell_start.size() - 1;
+
+	// monopole (mass, center of mass) and bounding box of the members of every cell
+	std::vector<double> cell_mass (cell_count), cell_extent (cell_count), cell_boxes (6*cell_count);
+	std::vector<cartesian_vector> cell_center (cell_count);
+	for (int c=0; c<cell_count; c++) {
+		double mass = 0., * member_box = &cell_boxes[6*c];
+		cartesian_vector center (0., 0., 0.);
+		for (int a=0; a<3; a++) { member_box[a] = largest; member_box[a+3] = -largest; }
+
+		for (int m=cell_start[c]; m<cell_start[c+1]; m++) {
+			const body & object = bodies[members[m]];
+			mass += object.mass;
+			center += object.mass * object.position;
+			for (int a=0; a<3; a++) {
+				member_box[a] = std::min(member_box[a], coordinate(object.position, a));
+				member_box[a+3] = std::max(member_box[a+3], coordinate(object.position, a));
+			}
+		}
+
+		cell_mass[c] = mass;
+		cell_center[c] = (mass > 0.) ? center/mass : center;
+		cell_extent[c] = std::max(std::max(member_box[3] - member_box[0], member_box[4] - member_box[1]), member_box[5] - member_box[2]);
+	}
+
+	// the cell boxes of all processes describe where the bodies of the other processes are
+	int box_values = cell_boxes.size();
+	std::vector<int> box_counts (process_count), box_offsets (process_count, 0);
+	MPI_Allgather(&box_values, 1, MPI_INT, box_counts.data(), 1, MPI_INT, communicator);
+	for (int p=1; p<process_count; p++) { box_offsets[p] = box_offsets[p-1] + box_counts[p-1]; }
+
+	std::vector<double> boxes (box_offsets[process_count-1] + box_counts[process_count-1]);
+	MPI_Allgatherv(cell_boxes.data(), box_values, MPI_DOUBLE, boxes.data(), box_counts.data(), box_offsets.data(), MPI_DOUBLE, communicator);
+
+	// point masses (x, y, z, m) for every other process: the monopole of a cell, if its extent is smaller than the opening angle
+	// times the distance of its center of mass to the closest cell box of the other process, otherwise all its bodies
+	std::vector<std::vector<double> > outgoing (process_count);
+	for (int p=0; p<process_count; p++) {
+		if (p == process_rank || box_counts[p] == 0) { continue; }
+
+		for (int c=0; c<cell_count; c++) {
+			double closest_squared = largest;
+			for (int other=box_offsets[p]; other<box_offsets[p]+box_counts[p]; other+=6) {
+				double distance_squared = 0.;
+				for (int a=0; a<3; a++) {
+					double x = coordinate(cell_center[c], a);
+					double gap = std::max(std::max(boxes[other+a] - x, x - boxes[other+a+3]), 0.);
+					distance_squared += gap*gap;
+				}
+				closest_squared = std::min(closest_squared, distance_squared);
+			}
+
+			if (cell_mass[c] > 0. && cell_extent[c]*cell_extent[c] < opening_angle*opening_angle*closest_squared) {
+				double monopole[4] = { cell_center[c].x, cell_center[c].y, cell_center[c].z, cell_mass[c] };
+				outgoing[p].insert(outgoing[p].end(), monopole, monopole + 4);
+				continue;
+			}
+
+			for (int m=cell_start[c]; m<cell_start[c+1]; m++) {
+				const body & object = bodies[members[m]];
+				double point[4] = { object.position.x, object.position.y, object.position.z, object.mass };
+				outgoing[p].insert(outgoing[p].end(), point, point + 4);
+			}
+		}
+	}
+
+	std::vector<int> send_counts (process_count), send_offsets (process_count, 0), receive_counts (process_count), receive_offsets (process_count, 0);
+	std::vector<double> send_buffer;
+	for (int p=0; p<process_count; p++) {
+		send_counts[p] = outgoing[p].size();
+		send_offsets[p] = send_buffer.size();
+		send_buffer.insert(send_buffer.end(), outgoing[p].begin(), outgoing[p].end());
+	}
+
+	MPI_Alltoall(send_counts.data(), 1, MPI_INT, receive_counts.data(), 1, MPI_INT, communicator);
+	for (int p=1; p<process_count; p++) { receive_offsets[p] = receive_offsets[p-1] + receive_counts[p-1]; }
+
+	std::vector<double> ghosts (receive_offsets[process_count-1] + receive_counts[process_count-1]);
+	MPI_Alltoallv(send_buffer.data(), send_counts.data(), send_offsets.data(), MPI_DOUBLE,
+			ghosts.data(), receive_counts.data(), receive_offsets.data(), MPI_DOUBLE, communicator);
+
+	const int ghost_total = ghosts.size()/4;
+	ghost_count += ghost_total;
+	force_count++;
+
+	double exchanged = MPI_Wtime();
+	communication_time += exchanged - start;
+
+	// sources: the local bodies followed by the ghosts
+	const int source_count = n + ghost_total;
+	std::vector<double> sx (source_count), sy (source_count), sz (source_count), sm (source_count);
+	for (int i=0; i<n; i++) {
+		sx[i] = bodies[i].position.x; sy[i] = bodies[i].position.y; sz[i] = bodies[i].position.z; sm[i] = bodies[i].mass;
+	}
+	for (int g=0; g<ghost_total; g++) {
+		sx[n+g] = ghosts[4*g]; sy[n+g] = ghosts[4*g+1]; sz[n+g] = ghosts[4*g+2]; sm[n+g] = ghosts[4*g+3];
+	}
+
+	acceleration.resize(n);
+	if (potential != nullptr) { potential->resize(n); }
+
+	#pragma omp parallel for schedule(dynamic, 16)
+	for (int i=0; i<n; i++) {
+		const double x = sx[i], y = sy[i], z = sz[i];
+		double acc_x = 0., acc_y = 0., acc_z = 0., phi = 0.;
+
+		// the source range is split at the body itself to keep the inner loops free of branches
+		for (int part=0; part<2; part++) {
+			int first = (part == 0) ? 0 : i + 1, last = (part == 0) ? i : source_count;
+
+			#pragma omp simd reduction(+:acc_x, acc_y, acc_z, phi)
+			for (int j=first; j<last; j++) {
+				double dx = sx[j] - x, dy = sy[j] - y, dz = sz[j] - z, pair_potential;
+				double factor = direct_kernel(dx, dy, dz, sm[j], pair_potential);
+				acc_x += factor*dx; acc_y += factor*dy; acc_z += factor*dz;
+				phi += pair_potential;
+			}
+		}
+
+		acceleration[i] = cartesian_vector(acc_x, acc_y, acc_z);
+		if (potential != nullptr) { (*potential)[i] = phi; }
+	}
+
+	computation_time += MPI_Wtime() - exchanged;
+}
+
+
+void domain_decomposition::migrate(std::vector<body> & bodies, std::vector<cartesian_vector> & acceleration, std::vector<double> & potential) {
+	/*
+	 * Sends the bodies outside of the local slab to their owners and rebalances the slabs if necessary.
+	 */
+	double start = MPI_Wtime();
+	exchange(bodies, acceleration, potential);
+
+	// rebalance, if the largest process owns too many bodies
+	long local_count = bodies.size(), largest_count, total_count;
+	MPI_Allreduce(&local_count, &largest_count, 1, MPI_LONG, MPI_MAX, communicator);
+	MPI_Allreduce(&local_count, &total_count, 1, MPI_LONG, MPI_SUM, communicator);
+
+	if (largest_count > (1. + imbalance_tolerance)*total_count/process_count) {
+		rebalance(bodies);
+		rebalance_count++;
+		exchange(bodies, acceleration, potential);
+	}
+
+	communication_time += MPI_Wtime() - start;
+}
+
+
+void domain_decomposition::exchange(std::vector<body> & bodies, std::vector<cartesian_vector> & acceleration, std::vector<double> & potential) {
+	/*
+	 * Moves every body to the owner of its slab together with its identifier, acceleration and potential.
+	 */
+	const int record = 12;
+	potential.resize(bodies.size(), 0.);
+
+	std::vector<std::vector<double> > outgoing (process_count);
+	unsigned int kept = 0;
+	for (unsigned int i=0; i<bodies.size(); i++) {
+		int p = owner(bodies[i].position);
+		if (p == process_rank) {
+			bodies[kept] = bodies[i]; acceleration[kept] = acceleration[i]; potential[kept] = potential[i]; identifier[kept] = identifier[i];
+			kept++;
+			continue;
+		}
+
+		const body & object = bodies[i];
+		double values[record] = { (double) identifier[i], object.mass, object.position.x, object.position.y, object.position.z,
+				object.velocity.x, object.velocity.y, object.velocity.z, acceleration[i].x, acceleration[i].y, acceleration[i].z, potential[i] };
+		outgoing[p].insert(outgoing[p].end(), values, values + record);
+	}
+	bodies.resize(kept); acceleration.resize(kept); potential.resize(kept); identifier.resize(kept);
+
+	std::vector<int> send_counts (process_count), send_offsets (process_count, 0), receive_counts (process_count), receive_offsets (process_count, 0);
+	std::vector<double> send_buffer;
+	for (int p=0; p<process_count; p++) {
+		send_counts[p] = outgoing[p].size();
+		send_offsets[p] = send_buffer.size();
+		send_buffer.insert(send_buffer.end(), outgoing[p].begin(), outgoing[p].end());
+	}
+
+	MPI_Alltoall(send_counts.data(), 1, MPI_INT, receive_counts.data(), 1, MPI_INT, communicator);
+	for (int p=1; p<process_count; p++) { receive_offsets[p] = receive_offsets[p-1] + receive_counts[p-1]; }
+
+	std::vector<double> incoming (receive_offsets[process_count-1] + receive_counts[process_count-1]);
+	MPI_Alltoallv(send_buffer.data(), send_counts.data(), send_offsets.data(), MPI_DOUBLE,
+			incoming.data(), receive_counts.data(), receive_offsets.data(), MPI_DOUBLE, communicator);
+
+	for (unsigned int r=0; r<incoming.size(); r+=record) {
+		const double * values = &incoming[r];
+		identifier.push_back((long) values[0]);
+		bodies.push_back(body(cartesian_vector(values[2], values[3], values[4]), cartesian_vector(values[5], values[6], values[7]), values[1]));
+		acceleration.push_back(cartesian_vector(values[8], values[9], values[10]));
+		potential.push_back(values[11]);
+	}
+}
+
+
+void domain_decomposition::rebalance(const std::vector<body> & bodies) {
+	/*
+	 * New boundaries from up to 256 evenly spaced (sorted) coordinates of every process,
+	 * every sample is weighted with the number of bodies it represents.
+	 */
+	const int sample_size = 256;
+	int n = bodies.size();
+
+	std::vector<double> local (n);
+	for (int i=0; i<n; i++) { local[i] = coordinate(bodies[i].position, axis); }
+	std::sort(local.begin(), local.end());
+
+	int count = std::min(n, sample_size);
+	std::vector<double> sample (2*sample_size, 0.);
+	for (int s=0; s<count; s++) {
+		sample[2*s] = local[((long) s*n)/count];
+		sample[2*s+1] = (double) n/count;
+	}
+
+	std::vector<double> samples (2*sample_size*process_count);
+	MPI_Allgather(sample.data(), 2*sample_size, MPI_DOUBLE, samples.data(), 2*sample_size, MPI_DOUBLE, communicator);
+
+	std::vector<double> coordinates, weights;
+	for (unsigned int s=0; s<samples.size(); s+=2) {
+		if (samples[s+1] > 0.) { coordinates.push_back(samples[s]); weights.push_back(samples[s+1]); }
+	}
+
+	choose_boundaries(coordinates, weights);
+}
+
+
+double domain_decomposition::total(double value) const {
+	double sum;
+	MPI_Allreduce(&value, &sum, 1, MPI_DOUBLE, MPI_SUM, communicator);
+	return sum;
+}
+
+
+std::vector<body> domain_decomposition::gather(const std::vector<body> & bodies) const {
+
+	const int record = 8;
+	std::vector<double> local;
+	for (unsigned int i=0; i<bodies.size(); i++) {
+		const body & object = bodies[i];
+		double values[record] = { (double) identifier[i], object.mass, object.position.x, object.position.y, object.position.z,
+				object.velocity.x, object.velocity.y, object.velocity.z };
+		local.insert(local.end(), values, values + record);
+	}
+
+	int local_size = local.size();
+	std::vector<int> sizes (process_count), offsets (process_count, 0);
+	MPI_Gather(&local_size, 1, MPI_INT, sizes.data(), 1, MPI_INT, 0, communicator);
+	for (int p=1; p<process_count; p++) { offsets[p] = offsets[p-1] + sizes[p-1]; }
+
+	std::vector<double> all ((process_rank == 0) ? offsets[process_count-1] + sizes[process_count-1] : 0);
+	MPI_Gatherv(local.data(), local_size, MPI_DOUBLE, all.data(), sizes.data(), offsets.data(), MPI_DOUBLE, 0, communicator);
+
+	std::vector<body> ordered (all.size()/record);
+	for (unsigned int r=0; r<all.size(); r+=record) {
+		const double * values = &all[r];
+		ordered[(long) values[0]] = body(cartesian_vector(values[2], values[3], values[4]), cartesian_vector(values[5], values[6], values[7]), values[1]);
+	}
+
+	return ordered;
+}
@@ -0,0 +1,155 @@
+/* FILE DISTRIBUTED_N_BODY.HPP */
+#ifndef FILE_DISTRIBUTED_N_BODY_HPP
+#define FILE_DISTRIBUTED_N_BODY_HPP
+
+#include "n-body.hpp"
+
+#include <mpi.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*
+ * Spatial domain decomposition of a system of bodies over the processes of an MPI communicator.
+ *
+ * Every process owns the bodies in one slab along the axis of the largest extent, the slab boundaries are chosen at quantiles of the
+ * coordinates, so that all processes own about the same number of bodies. Every body keeps its global identifier (its index in the
+ * initial body list), so that the output can be written in the original order.
+ *
+ * Force calculation (accelerations): every process splits its bodies recursively at the median of the widest extent into cells of
+ * at most leaf_size bodies (a flat k-d tree), the bounding boxes of all cells are exchanged. Every process then sends to every other process either the monopole
+ * (mass and center of mass) of a cell, if the cell is seen under an angle smaller than the opening_angle from all cell boxes of the
+ * other process, or all bodies of the cell. The received point masses (ghosts) are then summed directly together with the local bodies. With an opening angle of 0 all bodies are exchanged and the result equals the
+ * direct summation of generic_n_body.
+ *
+ * Load balancing (migrate): after every step the bodies that left the slab are sent to their new owner. If the largest process then
+ * owns more than (1 + imbalance_tolerance) times the average number of bodies, the boundaries are moved to the quantiles of a
+ * weighted sample of the coordinates gathered from all processes.
+ */
+class domain_decomposition {
+	public:
+		domain_decomposition (MPI_Comm communicator, double opening_angle);
+
+		// keeps the share of this process of the (identical) initial body list of all processes
+		void decompose(std::vector<body> & bodies);
+		bool decomposed() const { return is_decomposed; }
+
+		void accelerations(const std::vector<body> & bodies, std::vector<cartesian_vector> & acceleration, std::vector<double> * potential);
+		void migrate(std::vector<body> & bodies, std::vector<cartesian_vector> & acceleration, std::vector<double> & potential);
+
+		// sum over all processes
+		double total(double value) const;
+
+		// gathers all bodies on the root process (rank 0) in the original order, other processes receive an empty vector
+		std::vector<body> gather(const std::vector<body> & bodies) const;
+
+		int rank() const { return process_rank; }
+		int processes() const { return process_count; }
+
+		// statistics for the scaling benchmarks: wall clock time spent in the exchanges and in the force loop,
+		// number of force calculations, received ghosts (summed over all force calculations) and rebalances
+		double communication_time = 0., computation_time = 0.;
+		long force_count = 0, ghost_count = 0, rebalance_count = 0;
+
+		double opening_angle;
+		double imbalance_tolerance = .1;
+		int leaf_size = 32;
+
+	private:
+		MPI_Comm communicator;
+		int process_rank, process_count;
+		bool is_decomposed = false;
+
+		// slab axis (0, 1, 2) and the process_count - 1 upper slab boundaries
+		int axis = 0;
+		std::vector<double> boundaries;
+		std::vector<long> identifier;
+
+		int owner(const cartesian_vector & position) const;
+		void choose_boundaries(std::vector<double> coordinates, const std::vector<double> & weights);
+		void rebalance(const std::vector<body> & bodies);
+		void exchange(std::vector<body> & bodies, std::vector<cartesian_vector> & acceleration, std::vector<double> & potential);
+};
+
+
+/*
+ * Runs an integrator (leapfrog_n_body, rk2_n_body) on a system decomposed over the processes of an MPI communicator.
+ *
+ * Every process constructs the solver and adds the same bodies (e.g. with a generator and the same seed), the first force
+ * calculation keeps the share of every process. Only the root process (rank 0) writes to the output file.
+ *
+ * The particle-mesh solver, regularization and test particles are not supported in the distributed mode (std::logic_error).
+ *
+ * Example (mpirun -np 4 ./program):
+ *	distributed_n_body<leapfrog_n_body> solver (0., "plummer.dat", MPI_COMM_WORLD, .5);
+ *	solver.add_objects(bodies);
+ *	solver.simulate(1., .001, .1, false);
+ */
+template <class integrator>
+class distributed_n_body : public integrator {
+	public:
+		distributed_n_body (double time, std::string out_file_name, MPI_Comm communicator, double opening_angle)
+			: integrator(time, out_file_name), domains(communicator, opening_angle) {
+
+			// every process truncated the output file in the constructor, the root process must not write before that
+			MPI_Barrier(communicator);
+		}
+
+		domain_decomposition & decomposition() { return domains; }
+		double energy() const { return this->total_energy; }
+
+		void calculate_total_energy() {
+			/*
+			 * The kinetic and potential energies of the local bodies are summed over all processes (using the potential
+			 * of the last force calculation, it is recalculated if it is not available).
+			 */
+			if (!this->potential_valid) {
+				this->potential_requested = true;
+				calculate_accelerations();
+			}
+
+			double energy = 0.;
+			for (unsigned int i=0; i<this->body_list.size(); i++) {
+				body & object = this->body_list[i];
+				energy += .5*object.mass*(object.velocity*object.velocity) + .5*object.mass*this->last_potential[i];
+			}
+
+			this->total_energy_previous = this->total_energy;
+			this->total_energy = domains.total(energy);
+		}
+
+	protected:
+		domain_decomposition domains;
+
+		void calculate_accelerations() {
+			if (this->mesh || this->regularization_radius > 0. || this->test_particles.size() > 0) {
+				throw std::logic_error("distributed_n_body: particle-mesh, regularization and test particles are not supported");
+			}
+
+			if (!domains.decomposed()) { domains.decompose(this->body_list); }
+
+			this->last_potential.resize(this->body_list.size());
+			domains.accelerations(this->body_list, this->last_acceleration, this->potential_requested ? &this->last_potential : nullptr);
+			this->potential_valid = this->potential_requested;
+		}
+
+		void step(double time_step) {
+			integrator::step(time_step);
+
+			// the accelerations (and potentials) at the end of the step move with the bodies
+			domains.migrate(this->body_list, this->last_acceleration, this->last_potential);
+		}
+
+		void write_state() {
+			std::vector<body> bodies = domains.gather(this->body_list);
+			if (domains.rank() != 0) { return; }
+
+			this->output_file << this->time << ' ' << this->total_energy << ' ';
+			for (unsigned int i=0; i<bodies.size(); i++) {
+				this->output_file << bodies[i].position << ' ' << bodies[i].velocity << ' ';
+			}
+			this->output_file << std::endl;
+		}
+};
+
+#endif /* FILE_DISTRIBUTED_N_BODY_HPP */
@@ -0,0 +1,91 @@
+#include "fft.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+
+fft_3d::fft_3d (int n) : n(n), log2_n(0) {
+
+	while ((1 << log2_n) < n) { log2_n++; }
+	if (n < 2 || (1 << log2_n) != n) { throw std::invalid_argument("fft_3d: the grid size has to be a power of two"); }
+
+	const double pi = 3.141592653589793;
+
+	// exp(-2 pi i m / n) for m < n/2
+	twiddle.resize(n/2);
+	for (int m=0; m<n/2; m++) { twiddle[m] = std::polar(1., -2.*pi*m/n); }
+
+	bit_reversed.resize(n);
+	for (int m=0; m<n; m++) {
+		int reversed = 0;
+		for (int bit=0; bit<log2_n; bit++) {
+			if (m & (1 << bit)) { reversed |= 1 << (log2_n - 1 - bit); }
+		}
+		bit_reversed[m] = reversed;
+	}
+}
+
+
+void fft_3d::transform_line(std::complex<double> * line, bool inverse) const {
+	/*
+	 * Iterative in-place radix-2 Cooley-Tukey transform of n contiguous values.
+	 */
+	for (int m=0; m<n; m++) {
+		if (m < bit_reversed[m]) { std::swap(line[m], line[bit_reversed[m]]); }
+	}
+
+	for (int length=2; length<=n; length*=2) {
+		int half = length/2, twiddle_stride = n/length;
+
+		for (int start=0; start<n; start+=length) {
+			for (int m=0; m<half; m++) {
+				std::complex<double> w = twiddle[m*twiddle_stride];
+				if (inverse) { w = std::conj(w); }
+
+				std::complex<double> even = line[start + m];
+				std::complex<double> odd = w * line[start + m + half];
+				line[start + m] = even + odd;
+				line[start + m + half] = even - odd;
+			}
+		}
+	}
+}
+
+
+void fft_3d::transform(std::vector<std::complex<double> > & grid, bool inverse) const {
+
+	const long n2 = (long) n*n;
+
+	// stride between consecutive points along the axis: z (contiguous), y, x
+	const long strides[3] = { 1, n, n2 };
+
+	for (int axis=0; axis<3; axis++) {
+		long stride = strides[axis];
+
+		#pragma omp parallel
+		{
+			std::vector<std::complex<double> > line (n);
+
+			#pragma omp for schedule(static)
+			for (long l=0; l<n2; l++) {
+				// the line l starts at the point with the two other coordinates given by l
+				long base;
+				if (axis == 0) { base = l*n; }
+				else if (axis == 1) { base = (l / n)*n2 + (l % n); }
+				else { base = l; }
+
+				for (int m=0; m<n; m++) { line[m] = grid[base + m*stride]; }
+				transform_line(line.data(), inverse);
+				for (int m=0; m<n; m++) { grid[base + m*stride] = line[m]; }
+			}
+		}
+	}
+
+	if (inverse) {
+		const double normalization = 1./((double) n2*n);
+		const long total = n2*n;
+
+		#pragma omp parallel for schedule(static)
+		for (long m=0; m<total; m++) { grid[m] *= normalization; }
+	}
+}
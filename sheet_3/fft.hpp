@@ -0,0 +1,35 @@
+/* FILE FFT.HPP */
+#ifndef FILE_FFT_HPP
+#define FILE_FFT_HPP
+
+#include <complex>
+#include <vector>
+
+/*
+ * Self-contained fast Fourier transform of a cubic grid with n^3 points (n has to be a power of two).
+ *
+ * The grid is stored in a std::vector with the index (i*n + j)*n + k for the point (i, j, k).
+ * The 3D transform consists of 1D radix-2 transforms along each axis, the lines of every axis are split between threads.
+ *
+ * forward:  F(k) = sum_x f(x) exp(-2 pi i k x / n)
+ * inverse:  f(x) = 1/n^3 sum_k F(k) exp(2 pi i k x / n)
+ */
+class fft_3d {
+	public:
+		fft_3d (int n);
+
+		void forward(std::vector<std::complex<double> > & grid) const { transform(grid, false); }
+		void inverse(std::vector<std::complex<double> > & grid) const { transform(grid, true); }
+
+		int size() const { return n; }
+
+	private:
+		int n, log2_n;
+		std::vector<std::complex<double> > twiddle;
+		std::vector<int> bit_reversed;
+
+		void transform(std::vector<std::complex<double> > & grid, bool inverse) const;
+		void transform_line(std::complex<double> * line, bool inverse) const;
+};
+
+#endif /* FILE_FFT_HPP */
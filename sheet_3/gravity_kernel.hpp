@@ -0,0 +1,19 @@
+/* FILE GRAVITY_KERNEL.HPP */
+#ifndef FILE_GRAVITY_KERNEL_HPP
+#define FILE_GRAVITY_KERNEL_HPP
+
+#include <cmath>
+
+/*
+ * Direct Newtonian interaction with a point mass at the separation (dx, dy, dz) = x_source - x_target.
+ *
+ * Returns m/|d|^3, the acceleration is this factor times (dx, dy, dz). The potential -m/|d| is stored in potential.
+ * Inline, so that it can be used in vectorized loops (test particles, short range part of the particle mesh solver).
+ */
+inline double direct_kernel(double dx, double dy, double dz, double mass, double & potential) {
+	double inverse_distance = 1./std::sqrt(dx*dx + dy*dy + dz*dz);
+	potential = -mass*inverse_distance;
+	return mass * inverse_distance*inverse_distance*inverse_distance;
+}
+
+#endif /* FILE_GRAVITY_KERNEL_HPP */
@@ -0,0 +1,261 @@
+#include "initial_conditions.hpp"
+#include "bulk_random.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+static const double pi = 3.141592653589793;
+
+
+static cartesian_vector isotropic_direction(counter_rng::sequence & random) {
+	/*
+	 * Returns a unit vector pointing into a random direction (uniformly distributed on the sphere).
+	 */
+	double cos_theta = 2.*random.uniform() - 1.;
+	double sin_theta = std::sqrt(1. - cos_theta*cos_theta);
+	double phi = 2.*pi*random.uniform();
+
+	return cartesian_vector(sin_theta*std::cos(phi), sin_theta*std::sin(phi), cos_theta);
+}
+
+
+void plummer_sphere(std::vector<body> & bodies, unsigned int count, double total_mass, double scale_radius, std::uint64_t seed) {
+	/*
+	 * Plummer model (Aarseth, Henon & Wielen 1974):
+	 *	the radius is drawn by inverting the cumulative mass M(r)/M = r^3/(r^2 + a^2)^(3/2),
+	 *	the speed in units of the local escape speed is drawn from g(q) = q^2 (1 - q^2)^(7/2) via rejection sampling (g <= 0.1).
+	 */
+
+	const counter_rng rng (seed);
+	const unsigned int first = bodies.size();
+	bodies.resize(first + count);
+
+	#pragma omp parallel for schedule(static)
+	for (unsigned int i=0; i<count; i++) {
+		counter_rng::sequence random = rng.sequence_for(i);
+
+		// truncate at 99.9% of the mass, otherwise single bodies might be placed extremely far away
+		double mass_fraction = .999*random.uniform() + 1e-10;
+		double radius = scale_radius / std::sqrt(std::pow(mass_fraction, -2./3.) - 1.);
+
+		double q, g;
+		do {
+			q = random.uniform();
+			g = .1*random.uniform();
+		} while (g > q*q*std::pow(1. - q*q, 3.5));
+
+		double escape_velocity = std::sqrt(2.*total_mass) * std::pow(radius*radius + scale_radius*scale_radius, -.25);
+
+		bodies[first + i] = body(radius * isotropic_direction(random), q*escape_velocity * isotropic_direction(random), total_mass/count);
+	}
+}
+
+
+static double king_density(double w) {
+	/*
+	 * Density of a King model (up to a constant factor) as a function of the dimensionless potential W = (phi_t - phi)/sigma^2.
+	 */
+	if (w <= 0.) { return 0.; }
+	return std::exp(w)*std::erf(std::sqrt(w)) - std::sqrt(4.*w/pi)*(1. + 2.*w/3.);
+}
+
+
+void king_sphere(std::vector<body> & bodies, unsigned int count, double total_mass, double core_radius, double w0, std::uint64_t seed) {
+	/*
+	 * King model (King 1966).
+	 *
+	 * In units of the King radius r_0, sigma = 1 and G = 1 the potential obeys
+	 *	W'' + 2/r W' = -9 rho(W)/rho(w0),   W(0) = w0, W'(0) = 0
+	 * and the enclosed mass is dM/dr = 9 r^2 rho(W)/rho(w0). This is integrated once (serially, with rk4) up to the tidal radius W = 0,
+	 * the radii of the bodies are then drawn by inverting the tabulated M(r).
+	 *
+	 * The speed in units of the local escape speed sqrt(2W) follows q^2 (exp(W (1 - q^2)) - 1), it is drawn via rejection sampling.
+	 */
+
+	const double central_density = king_density(w0);
+
+	std::vector<double> table_radius, table_mass, table_w;
+
+	// start slightly off the center using the series expansion W = w0 - 3/2 r^2
+	double r = 1e-4, w = w0 - 1.5*r*r, dw = -3.*r, mass = 3.*r*r*r;
+	table_radius.push_back(0.); table_mass.push_back(0.); table_w.push_back(w0);
+
+	while (w > 0.) {
+		table_radius.push_back(r); table_mass.push_back(mass); table_w.push_back(w);
+
+		double h = 1e-3 * std::max(1., r);
+
+		// state derivatives: (W, W', M)' = (W', -9 rho - 2/r W', 9 r^2 rho)
+		double k_w[4], k_dw[4], k_m[4];
+		double stage_w = w, stage_dw = dw, stage_r = r;
+		for (int k=0; k<4; k++) {
+			double density = king_density(stage_w)/central_density;
+			k_w[k] = stage_dw;
+			k_dw[k] = -9.*density - 2./stage_r*stage_dw;
+			k_m[k] = 9.*stage_r*stage_r*density;
+
+			double fraction = (k < 2) ? .5 : 1.;
+			stage_w = w + fraction*h*k_w[k];
+			stage_dw = dw + fraction*h*k_dw[k];
+			stage_r = r + fraction*h;
+		}
+
+		double new_w = w + h/6.*(k_w[0] + 2.*k_w[1] + 2.*k_w[2] + k_w[3]);
+		dw += h/6.*(k_dw[0] + 2.*k_dw[1] + 2.*k_dw[2] + k_dw[3]);
+		mass += h/6.*(k_m[0] + 2.*k_m[1] + 2.*k_m[2] + k_m[3]);
+
+		// linear interpolation of the tidal radius for the last table entry
+		if (new_w <= 0.) { r += h * w/(w - new_w); w = 0.; }
+		else { r += h; w = new_w; }
+	}
+	table_radius.push_back(r); table_mass.push_back(mass); table_w.push_back(0.);
+
+	const double dimensionless_mass = mass;
+
+	// scaling from the dimensionless model (r_0 = 1, M = dimensionless_mass) to the requested core radius and total mass
+	const double velocity_scale = std::sqrt(total_mass/dimensionless_mass / core_radius);
+
+	const counter_rng rng (seed);
+	const unsigned int first = bodies.size();
+	bodies.resize(first + count);
+
+	#pragma omp parallel for schedule(static)
+	for (unsigned int i=0; i<count; i++) {
+		counter_rng::sequence random = rng.sequence_for(i);
+
+		double enclosed_mass = random.uniform() * dimensionless_mass;
+		unsigned int k = std::upper_bound(table_mass.begin(), table_mass.end(), enclosed_mass) - table_mass.begin();
+		k = std::min(std::max(k, 1u), (unsigned int) table_mass.size() - 1);
+
+		double fraction = (enclosed_mass - table_mass[k-1]) / (table_mass[k] - table_mass[k-1]);
+		double radius = table_radius[k-1] + fraction*(table_radius[k] - table_radius[k-1]);
+		double local_w = table_w[k-1] + fraction*(table_w[k] - table_w[k-1]);
+
+		double q = 0.;
+		if (local_w > 0.) {
+			// upper bound of the distribution for the rejection sampling from a coarse scan
+			double maximum = 0.;
+			for (int s=1; s<=64; s++) {
+				double x = s/64.;
+				maximum = std::max(maximum, x*x*(std::exp(local_w*(1. - x*x)) - 1.));
+			}
+			maximum *= 1.2;
+
+			double g;
+			do {
+				q = random.uniform();
+				g = maximum*random.uniform();
+			} while (g > q*q*(std::exp(local_w*(1. - q*q)) - 1.));
+		}
+
+		double speed = q * std::sqrt(2.*local_w);
+
+		bodies[first + i] = body(core_radius*radius * isotropic_direction(random), velocity_scale*speed * isotropic_direction(random), total_mass/count);
+	}
+}
+
+
+void uniform_sphere(std::vector<body> & bodies, unsigned int count, double total_mass, double radius, double max_velocity, std::uint64_t seed) {
+	/*
+	 * Homogeneous sphere, the radius is drawn as R u^(1/3) (no rejection sampling required).
+	 */
+
+	const counter_rng rng (seed);
+	const unsigned int first = bodies.size();
+	bodies.resize(first + count);
+
+	#pragma omp parallel for schedule(static)
+	for (unsigned int i=0; i<count; i++) {
+		counter_rng::sequence random = rng.sequence_for(i);
+
+		cartesian_vector position = radius*std::cbrt(random.uniform()) * isotropic_direction(random);
+		cartesian_vector velocity (random.uniform(-max_velocity, max_velocity), random.uniform(-max_velocity, max_velocity), random.uniform(-max_velocity, max_velocity));
+
+		bodies[first + i] = body(position, velocity, total_mass/count);
+	}
+}
+
+
+void disk(std::vector<body> & bodies, unsigned int count, double disk_mass, double central_mass, double inner_radius, double outer_radius,
+		double scale_height, std::uint64_t seed) {
+	/*
+	 * Disk in the x-y plane with constant surface density, the vertical positions are normally distributed with the scale height.
+	 * The bodies rotate counterclockwise with the circular velocity due to the central mass plus the disk mass inside their radius.
+	 */
+
+	const counter_rng rng (seed);
+	const unsigned int first = bodies.size();
+	bodies.resize(first + count);
+
+	const double inner_squared = inner_radius*inner_radius, outer_squared = outer_radius*outer_radius;
+
+	#pragma omp parallel for schedule(static)
+	for (unsigned int i=0; i<count; i++) {
+		counter_rng::sequence random = rng.sequence_for(i);
+
+		double radius = std::sqrt(inner_squared + random.uniform()*(outer_squared - inner_squared));
+		double phi = 2.*pi*random.uniform();
+		double height = scale_height*random.normal();
+
+		double enclosed_mass = central_mass + disk_mass*(radius*radius - inner_squared)/(outer_squared - inner_squared);
+		double circular_velocity = std::sqrt(enclosed_mass/radius);
+
+		cartesian_vector position (radius*std::cos(phi), radius*std::sin(phi), height);
+		cartesian_vector velocity (-circular_velocity*std::sin(phi), circular_velocity*std::cos(phi), 0.);
+
+		bodies[first + i] = body(position, velocity, disk_mass/count);
+	}
+}
+
+
+void keplerian_orbits(std::vector<body> & bodies, unsigned int count, double body_mass, double central_mass,
+		double min_semi_major_axis, double max_semi_major_axis, double max_eccentricity, double max_inclination, std::uint64_t seed) {
+	/*
+	 * The orbital elements are drawn uniformly: a in [min, max], e in [0, max_eccentricity], i in [0, max_inclination],
+	 * the longitude of the ascending node, the argument of the periapsis and the mean anomaly in [0, 2 pi).
+	 * Kepler's equation E - e sin(E) = M is solved with Newton's method.
+	 */
+
+	const counter_rng rng (seed);
+	const unsigned int first = bodies.size();
+	bodies.resize(first + count);
+
+	const double mu = central_mass + body_mass;
+
+	#pragma omp parallel for schedule(static)
+	for (unsigned int i=0; i<count; i++) {
+		counter_rng::sequence random = rng.sequence_for(i);
+
+		double a = random.uniform(min_semi_major_axis, max_semi_major_axis);
+		double e = random.uniform(0., max_eccentricity);
+		double inclination = random.uniform(0., max_inclination);
+		double node = 2.*pi*random.uniform();
+		double periapsis = 2.*pi*random.uniform();
+		double mean_anomaly = 2.*pi*random.uniform();
+
+		double E = (e < .8) ? mean_anomaly : pi;
+		for (int iteration=0; iteration<50; iteration++) {
+			double correction = (E - e*std::sin(E) - mean_anomaly)/(1. - e*std::cos(E));
+			E -= correction;
+			if (std::abs(correction) < 1e-14) { break; }
+		}
+
+		// position and velocity in the orbital plane (periapsis along the x axis)
+		double mean_motion = std::sqrt(mu/(a*a*a));
+		double root = std::sqrt(1. - e*e);
+		double denominator = 1. - e*std::cos(E);
+
+		double x = a*(std::cos(E) - e), y = a*root*std::sin(E);
+		double vx = -a*mean_motion*std::sin(E)/denominator, vy = a*mean_motion*root*std::cos(E)/denominator;
+
+		// rotation into the reference frame: R_z(node) R_x(inclination) R_z(periapsis)
+		double cos_node = std::cos(node), sin_node = std::sin(node);
+		double cos_i = std::cos(inclination), sin_i = std::sin(inclination);
+		double cos_w = std::cos(periapsis), sin_w = std::sin(periapsis);
+
+		cartesian_vector p (cos_node*cos_w - sin_node*sin_w*cos_i, sin_node*cos_w + cos_node*sin_w*cos_i, sin_w*sin_i);
+		cartesian_vector q (-cos_node*sin_w - sin_node*cos_w*cos_i, -sin_node*sin_w + cos_node*cos_w*cos_i, cos_w*sin_i);
+
+		bodies[first + i] = body(x*p + y*q, vx*p + vy*q, body_mass);
+	}
+}
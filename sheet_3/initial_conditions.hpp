@@ -0,0 +1,40 @@
+/* FILE INITIAL_CONDITIONS.HPP */
+#ifndef FILE_INITIAL_CONDITIONS_HPP
+#define FILE_INITIAL_CONDITIONS_HPP
+
+#include "vector.hpp"
+#include "body.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/*
+ * Generators for initial conditions (in units with G = 1, as used by generic_n_body).
+ *
+ * Every generator appends count bodies to the given std::vector. The bodies are generated in parallel, body i only uses
+ * the random numbers of counter_rng(seed).sequence_for(i), so the result is reproducible from the seed and independent of the
+ * number of threads.
+ *
+ * The bodies can then be handed to a simulation with generic_n_body::add_objects or generic_n_body::add_test_particles
+ * (the latter ignores the masses, e.g. for a debris disk).
+ *
+ *	plummer_sphere:    Plummer model with the given total mass and scale radius (truncated at 99.9% of the mass)
+ *	king_sphere:       King model with the dimensionless central potential w0, the core (King) radius and the total mass
+ *	uniform_sphere:    homogeneous sphere, the velocities are uniformly distributed in [-max_velocity, max_velocity]^3
+ *	disk:              thin disk with constant surface density between inner and outer radius on circular orbits around a central mass
+ *	keplerian_orbits:  bodies on random Kepler orbits around a central mass, which is located at the origin and at rest
+ */
+
+void plummer_sphere(std::vector<body> & bodies, unsigned int count, double total_mass, double scale_radius, std::uint64_t seed);
+
+void king_sphere(std::vector<body> & bodies, unsigned int count, double total_mass, double core_radius, double w0, std::uint64_t seed);
+
+void uniform_sphere(std::vector<body> & bodies, unsigned int count, double total_mass, double radius, double max_velocity, std::uint64_t seed);
+
+void disk(std::vector<body> & bodies, unsigned int count, double disk_mass, double central_mass, double inner_radius, double outer_radius,
+		double scale_height, std::uint64_t seed);
+
+void keplerian_orbits(std::vector<body> & bodies, unsigned int count, double body_mass, double central_mass,
+		double min_semi_major_axis, double max_semi_major_axis, double max_eccentricity, double max_inclination, std::uint64_t seed);
+
+#endif /* FILE_INITIAL_CONDITIONS_HPP */
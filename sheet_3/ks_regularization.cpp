@@ -0,0 +1,146 @@
+#include "ks_regularization.hpp"
+#include <cmath>
+
+
+static void ks_matrix(const double u[4], const double v[4], double result[4]) {
+	/*
+	 * result = L(u) v with the KS matrix
+	 *	L(u) = ( u0 -u1 -u2  u3 )
+	 *	       ( u1  u0 -u3 -u2 )
+	 *	       ( u2  u3  u0  u1 )
+	 *	       ( u3 -u2  u1 -u0 )
+	 */
+	result[0] = u[0]*v[0] - u[1]*v[1] - u[2]*v[2] + u[3]*v[3];
+	result[1] = u[1]*v[0] + u[0]*v[1] - u[3]*v[2] - u[2]*v[3];
+	result[2] = u[2]*v[0] + u[3]*v[1] + u[0]*v[2] + u[1]*v[3];
+	result[3] = u[3]*v[0] - u[2]*v[1] + u[1]*v[2] - u[0]*v[3];
+}
+
+static void ks_matrix_transposed(const double u[4], const double v[4], double result[4]) {
+	/*
+	 * result = L(u)^T v
+	 */
+	result[0] =  u[0]*v[0] + u[1]*v[1] + u[2]*v[2] + u[3]*v[3];
+	result[1] = -u[1]*v[0] + u[0]*v[1] + u[3]*v[2] - u[2]*v[3];
+	result[2] = -u[2]*v[0] - u[3]*v[1] + u[0]*v[2] + u[1]*v[3];
+	result[3] =  u[3]*v[0] - u[2]*v[1] + u[1]*v[2] - u[0]*v[3];
+}
+
+
+ks_pair::ks_pair (int first, int second, double first_mass, double second_mass, cartesian_vector relative_position, cartesian_vector relative_velocity)
+	: first(first), second(second), first_mass(first_mass), second_mass(second_mass) {
+
+	double r = relative_position.norm();
+
+	// inverse of x = L(u) u, choose the branch that avoids the division by a small number
+	if (relative_position.x >= 0.) {
+		u[0] = std::sqrt(.5*(r + relative_position.x));
+		u[1] = .5*relative_position.y/u[0];
+		u[2] = .5*relative_position.z/u[0];
+		u[3] = 0.;
+	}
+	else {
+		u[1] = std::sqrt(.5*(r - relative_position.x));
+		u[0] = .5*relative_position.y/u[1];
+		u[2] = 0.;
+		u[3] = .5*relative_position.z/u[1];
+	}
+
+	// u' = 1/2 L(u)^T v
+	double v[4] = { relative_velocity.x, relative_velocity.y, relative_velocity.z, 0. };
+	ks_matrix_transposed(u, v, du);
+	for (int k=0; k<4; k++) { du[k] *= .5; }
+
+	h = .5*(relative_velocity*relative_velocity) - (first_mass + second_mass)/r;
+}
+
+
+cartesian_vector ks_pair::relative_position() const {
+	double x[4];
+	ks_matrix(u, u, x);
+	return cartesian_vector(x[0], x[1], x[2]);
+}
+
+
+cartesian_vector ks_pair::relative_velocity() const {
+	// v = 2/r L(u) u'
+	double v[4];
+	ks_matrix(u, du, v);
+	double factor = 2./separation();
+	return cartesian_vector(factor*v[0], factor*v[1], factor*v[2]);
+}
+
+
+void ks_pair::rk4_step(double ds, const double perturbation[4], double & t) {
+	/*
+	 * One rk4 step in fictitious time for the state (u, u', h, t).
+	 */
+	const double u0[4] = { u[0], u[1], u[2], u[3] }, du0[4] = { du[0], du[1], du[2], du[3] };
+	const double h0 = h, t0 = t;
+
+	double k_u[4][4], k_du[4][4], k_h[4], k_t[4];
+	double stage_u[4], stage_du[4], stage_h = h0;
+	for (int c=0; c<4; c++) { stage_u[c] = u0[c]; stage_du[c] = du0[c]; }
+
+	for (int k=0; k<4; k++) {
+		double r = stage_u[0]*stage_u[0] + stage_u[1]*stage_u[1] + stage_u[2]*stage_u[2] + stage_u[3]*stage_u[3];
+		double projected[4];
+		ks_matrix_transposed(stage_u, perturbation, projected);
+
+		k_h[k] = 0.;
+		for (int c=0; c<4; c++) {
+			k_u[k][c] = stage_du[c];
+			k_du[k][c] = .5*stage_h*stage_u[c] + .5*r*projected[c];
+			k_h[k] += 2.*stage_du[c]*projected[c];
+		}
+		k_t[k] = r;
+
+		double fraction = (k < 2) ? .5*ds : ds;
+		for (int c=0; c<4; c++) {
+			stage_u[c] = u0[c] + fraction*k_u[k][c];
+			stage_du[c] = du0[c] + fraction*k_du[k][c];
+		}
+		stage_h = h0 + fraction*k_h[k];
+	}
+
+	for (int c=0; c<4; c++) {
+		u[c] = u0[c] + ds/6.*(k_u[0][c] + 2.*k_u[1][c] + 2.*k_u[2][c] + k_u[3][c]);
+		du[c] = du0[c] + ds/6.*(k_du[0][c] + 2.*k_du[1][c] + 2.*k_du[2][c] + k_du[3][c]);
+	}
+	h = h0 + ds/6.*(k_h[0] + 2.*k_h[1] + 2.*k_h[2] + k_h[3]);
+	t = t0 + ds/6.*(k_t[0] + 2.*k_t[1] + 2.*k_t[2] + k_t[3]);
+}
+
+
+void ks_pair::advance(double time_step, cartesian_vector perturbation) {
+	/*
+	 * Integrates in fictitious time with steps_per_orbit steps per (unperturbed) orbit until the physical time_step is reached.
+	 * The last step is shortened with a few Newton iterations on t(s) = time_step (dt/ds = r).
+	 */
+	const double pi = 3.141592653589793;
+	const double p[4] = { perturbation.x, perturbation.y, perturbation.z, 0. };
+
+	double t = 0.;
+	while (t < time_step) {
+		// the oscillator frequency in fictitious time is sqrt(-h/2), for unbound pairs fall back to a fraction of the time step
+		double ds = (h < 0.) ? 2.*pi/std::sqrt(-.5*h)/steps_per_orbit : time_step/(16.*separation());
+
+		double saved_u[4] = { u[0], u[1], u[2], u[3] }, saved_du[4] = { du[0], du[1], du[2], du[3] };
+		double saved_h = h, saved_t = t;
+
+		rk4_step(ds, p, t);
+		if (t <= time_step) { continue; }
+
+		// overshoot: redo the last step with the length that ends exactly at time_step
+		for (int iteration=0; iteration<4; iteration++) {
+			for (int c=0; c<4; c++) { u[c] = saved_u[c]; du[c] = saved_du[c]; }
+			h = saved_h;
+			if (iteration == 0) { ds = (time_step - saved_t)/separation(); }
+			t = saved_t;
+
+			rk4_step(ds, p, t);
+			ds += (time_step - t)/separation();
+		}
+		break;
+	}
+}
@@ -0,0 +1,50 @@
+/* FILE KS_REGULARIZATION.HPP */
+#ifndef FILE_KS_REGULARIZATION_HPP
+#define FILE_KS_REGULARIZATION_HPP
+
+#include "vector.hpp"
+
+/*
+ * Kustaanheimo-Stiefel regularized relative motion of a close, bound pair of bodies.
+ *
+ * The relative position x = x_second - x_first is represented by a 4D vector u with x = L(u) u and the physical time t is
+ * replaced by the fictitious time s with dt = r ds. The equations of motion
+ *
+ *	u'' = h/2 u + r/2 L(u)^T P,     h' = 2 u' . L(u)^T P,     t' = r = u . u
+ *
+ * (P is the perturbing relative acceleration, h the specific binding energy) have no singularity at r = 0 and are a harmonic
+ * oscillator for P = 0. Thereby a close binary can be integrated with a fixed number of steps per orbit, independent of the
+ * eccentricity, while the rest of the system keeps its large time step.
+ *
+ * The pair itself does not know about the bodies, generic_n_body keeps both members at the center of mass and uses
+ * relative_position() and relative_velocity() to recover the physical positions.
+ */
+class ks_pair {
+	public:
+		// indices of the members in the body list
+		int first, second;
+		double first_mass, second_mass;
+
+		ks_pair (int first, int second, double first_mass, double second_mass, cartesian_vector relative_position, cartesian_vector relative_velocity);
+
+		// integrate the relative motion over the physical time_step, the perturbation is assumed to be constant during the step
+		void advance(double time_step, cartesian_vector perturbation);
+
+		cartesian_vector relative_position() const;
+		cartesian_vector relative_velocity() const;
+		double separation() const { return u[0]*u[0] + u[1]*u[1] + u[2]*u[2] + u[3]*u[3]; }
+
+		// specific binding energy h = v^2/2 - M/r, the internal energy of the pair is reduced_mass * h
+		double binding_energy() const { return h; }
+		double internal_energy() const { return first_mass*second_mass/(first_mass + second_mass) * h; }
+
+	private:
+		double u[4], du[4], h;
+
+		// number of steps in fictitious time per orbit
+		static const int steps_per_orbit = 128;
+
+		void rk4_step(double ds, const double perturbation[4], double & t);
+};
+
+#endif /* FILE_KS_REGULARIZATION_HPP */
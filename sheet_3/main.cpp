@@ -1,6 +1,6 @@
 #include "n-body.hpp"
+#include "initial_conditions.hpp"
 
-#include <random>
 
 void one_leapfrog() {
 	leapfrog_n_body solver (0., std::string("1_a.dat"));
@@ -53,26 +53,30 @@ void task_c() {
 }
 
 void task_e() {
-	std::random_device rand;
-
 	leapfrog_n_body test_system (0., std::string("task_e.dat"));
 
-	int i = 0;
-	while (i<5) {
-		cartesian_vector pos = cartesian_vector(rand(), rand(), rand());
-		pos = 2. * pos / (double) rand.max() - cartesian_vector(1., 1., 1.);
+	// five bodies with mass .1 in the unit sphere, the velocity components are uniformly distributed in [-.1, .1]
+	// (fixed seed, the run is reproducible; the generator of initial_conditions.hpp is counter based)
+	std::vector<body> bodies;
+	uniform_sphere(bodies, 5, .5, 1., .1, 5);
+
+	test_system.add_objects(bodies);
+	test_system.simulate(1000., 0.001, 0.1, true);
+
+}
 
-		// reject points outside the unit sphere
-		if (pos.norm_squared() > 1.) { continue; }
+void task_live() {
+	leapfrog_n_body test_system (0., std::string("task_live.dat"));
 
-		cartesian_vector vel = cartesian_vector(rand(), rand(), rand());
-		vel = vel / (5.*rand.max()) - cartesian_vector(.1, .1, .1) ;
+	// follow the run with: ./monitor.out /nbody_live
+	state_publisher publisher ("/nbody_live", 1000);
+	test_system.attach_publisher(&publisher, 10);
 
-		test_system.add_object(body(pos, vel, .1));
-		i++;
-	}
-	test_system.simulate(1000., 0.001, 0.1, true);
+	std::vector<body> bodies;
+	plummer_sphere(bodies, 1000, 1., 1., 42);
 
+	test_system.add_objects(bodies);
+	test_system.simulate(10., 0.001, 1., false);
 }
 
 int main() {
@@ -84,6 +88,7 @@ int main() {
 	//task_b();
 	//task_c();
 	//task_e();
+	//task_live();
 
 	return 0;
 }
@@ -0,0 +1,65 @@
+#include "shared_state.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <thread>
+
+/*
+ * Live monitor for a simulation with an attached state_publisher (see shared_state.hpp and generic_n_body::attach_publisher).
+ *
+ * Usage: ./monitor.out name [interval_ms] [count]
+ *
+ * Prints the latest frame every interval_ms milliseconds (default 500, count times or until the segment disappears):
+ * frame, time, energy, number of bodies, center of mass, rms radius around it and the number of frames missed since the last print.
+ * The statistics are calculated directly in the shared memory (zero-copy), the frame is dropped if it was overwritten meanwhile.
+ */
+int main(int argc, char **argv) {
+	if (argc < 2 || argc > 4) {
+		std::cerr << "Usage: ./monitor.out name [interval_ms] [count]" << std::endl;
+		return 1;
+	}
+
+	int interval = (argc > 2) ? std::atoi(argv[2]) : 500;
+	long count = (argc > 3) ? std::atol(argv[3]) : -1;
+
+	try {
+		state_subscriber subscriber (argv[1]);
+		std::uint64_t last_frame = 0;
+
+		for (long printed=0; count < 0 || printed < count; ) {
+			std::uint64_t published = subscriber.published();
+			state_view view;
+
+			if (published > 0 && subscriber.view(published - 1, view)) {
+				double mass = 0., cx = 0., cy = 0., cz = 0., radius_squared = 0.;
+				for (unsigned int i=0; i<view.body_count; i++) {
+					mass += view.mass[i];
+					cx += view.mass[i]*view.x[i]; cy += view.mass[i]*view.y[i]; cz += view.mass[i]*view.z[i];
+				}
+				if (mass > 0.) { cx /= mass; cy /= mass; cz /= mass; }
+				for (unsigned int i=0; i<view.body_count; i++) {
+					radius_squared += view.mass[i]*((view.x[i]-cx)*(view.x[i]-cx) + (view.y[i]-cy)*(view.y[i]-cy) + (view.z[i]-cz)*(view.z[i]-cz));
+				}
+
+				if (subscriber.valid(view)) {
+					std::cout << view.frame << ' ' << view.time << ' ' << view.energy << ' ' << view.body_count << ' '
+						<< cx << ' ' << cy << ' ' << cz << ' ' << ((mass > 0.) ? std::sqrt(radius_squared/mass) : 0.) << ' '
+						<< ((printed > 0) ? view.frame - last_frame - 1 : 0) << std::endl;
+					last_frame = view.frame;
+					printed++;
+				}
+			}
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+		}
+	}
+	catch (std::exception & error) {
+		std::cerr << error.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -2,6 +2,7 @@
 #include <cmath>
 #include <algorithm>
 #include <iomanip>
+#include <stdexcept>
 
 
 generic_n_body::generic_n_body (double initial_time, std::string out_file_name) {
@@ -28,16 +29,35 @@ void generic_n_body::calculate_total_energy() {
 	 */
 
 	total_energy_previous = total_energy;
+	partner.resize(body_list.size(), -1);
 
 	double E_kin = 0., E_pot = 0.;
 	int n = body_list.size();
 
+	// regularized pairs are located at their center of mass, their internal energy is added separately
+	for (unsigned int k=0; k<regularized_pairs.size(); k++) {
+		E_pot += regularized_pairs[k].internal_energy();
+	}
+
+	// the last force calculation already accumulated the potential phi_i = -sum_j m_j / |x_i - x_j| at the current positions:
+	// E_pot = 1/2 sum_i m_i phi_i (the factor 1/2 corrects for counting every pair twice)
+	if (potential_valid) {
+		for (int i=0; i<n; i++) {
+			E_kin += .5*body_list[i].mass* body_list[i].velocity*body_list[i].velocity;
+			E_pot += .5*body_list[i].mass * last_potential[i];
+		}
+
+		total_energy = E_kin + E_pot;
+		return;
+	}
+
 	// iteration through all bodies, the inner loop only iterates until j=i-1,
 	// thereby no potential energies are accounted twice and no division by zero occurs (would occur in the inner loop if i = j)
 	for (int i=0; i<n; i++) {
 		E_kin += .5*body_list[i].mass* body_list[i].velocity*body_list[i].velocity;
 
 		for (int j=0; j<i; j++) {
+			if (j == partner[i]) { continue; }
 			E_pot -= body_list[i].mass * body_list[j].mass / ( body_list[i].position - body_list[j].position).norm();
 		}
 	}
@@ -51,16 +71,21 @@ void generic_n_body::write_state() {
 	 * Writes the current state to the output file in the following way:
 	 * time total energy position1 velocity1 position2 velocity2 ... endl
 	 *
-	 * The values are separated by spaces.
+	 * The values are separated by spaces. The test particles follow after the last body in the same format.
+	 * Members of regularized pairs are written at their physical positions.
 	 */
 
 	output_file << time << ' ' << total_energy << ' ';
 
-	// fancy way of looping through the body_list vector using an iterator
-	for (std::vector<body>::iterator iter = body_list.begin(); iter != body_list.end(); ++iter) {
+	std::vector<body> bodies = regularized_pairs.empty() ? body_list : physical_bodies();
+
+	// fancy way of looping through the bodies vector using an iterator
+	for (std::vector<body>::iterator iter = bodies.begin(); iter != bodies.end(); ++iter) {
 		output_file << iter->position << ' ' << iter->velocity << ' ';
 	}
 
+	test_particles.write(output_file);
+
 	output_file << std::endl;
 }
 
@@ -70,6 +95,37 @@ void generic_n_body::add_object (body object) {
 	 * Adds a new body to the vector storing all objects.
 	 */
 	body_list.push_back(object);
+
+	// the stored potentials do not include the new body
+	potential_valid = false;
+}
+
+
+void generic_n_body::add_test_particle(cartesian_vector position, cartesian_vector velocity) {
+	/*
+	 * Adds a new massless test particle.
+	 */
+	test_particles.add(position, velocity);
+}
+
+
+void generic_n_body::add_objects(const std::vector<body> & objects) {
+	/*
+	 * Adds all bodies of objects at once (e.g. from one of the generators in initial_conditions.hpp).
+	 */
+	body_list.insert(body_list.end(), objects.begin(), objects.end());
+
+	potential_valid = false;
+}
+
+
+void generic_n_body::add_test_particles(const std::vector<body> & particles) {
+	/*
+	 * Adds the positions and velocities of particles as test particles, their masses are ignored.
+	 */
+	for (unsigned int i=0; i<particles.size(); i++) {
+		test_particles.add(particles[i].position, particles[i].velocity);
+	}
 }
 
 
@@ -94,12 +150,23 @@ double generic_n_body::time_step_correction_factor() {
 void generic_n_body::calculate_accelerations() {
 	/*
 	 * Calculates the acceleration due to gravity for each body and stores the vectorial acceleration in a std::vector container.
-	 * The accelerations are accessible via the last_acceleration class member
+	 * The accelerations are accessible via the last_acceleration class member.
+	 *
+	 * The accelerations of the test particles are updated as well (they are stored in the test_particles member).
+	 *
+	 * If potential_requested is set (and the fused potential is enabled), the potential of each body is accumulated in the same pass
+	 * and stored in last_potential, it is then used by calculate_total_energy.
 	 */
 
+	if (mesh) { calculate_mesh_accelerations(); return; }
+
 	// adjust the size to account for recent body additions
 	int n = body_list.size();
 	last_acceleration.resize(n);
+	partner.resize(n, -1);
+
+	bool with_potential = fused_potential && potential_requested;
+	if (with_potential) { last_potential.assign(n, 0.); }
 
 
 	// double loop over all bodies to calculate the acceleration (i.e. the force)
@@ -108,15 +175,75 @@ void generic_n_body::calculate_accelerations() {
 
 		for (int j=0; j<n; j++) {
 
-			// ignore this case, as it would cause a division by 0
-			if (i==j) { continue; }
+			// ignore this case, as it would cause a division by 0 (the members of a regularized pair are at the same position)
+			if (i==j || j==partner[i]) { continue; }
 
 			// a_i = sum_j=0^N  ( m_j * (x_j - x_i)/|x_j - x_i|^3 )
+			// phi_i = -sum_j=0^N  m_j / |x_j - x_i|
 			cartesian_vector distance = body_list[j].position - body_list[i].position;
-			last_acceleration[i] += (body_list[j].mass/pow(distance.norm_squared(), 1.5)) * distance;
+			double inverse_distance = 1./distance.norm();
+			last_acceleration[i] += (body_list[j].mass * inverse_distance*inverse_distance*inverse_distance) * distance;
 
+			if (with_potential) { last_potential[i] -= body_list[j].mass * inverse_distance; }
 		}
 	}
+
+	potential_valid = with_potential;
+
+	test_particles.calculate_accelerations(body_list);
+}
+
+
+
+void generic_n_body::use_particle_mesh(double box_size, int grid_size, bool p3m) {
+	/*
+	 * Switches to the periodic particle-mesh gravity solver, grid_size has to be a power of two.
+	 * With p3m the mesh only provides the long range force and close pairs are summed directly.
+	 */
+	mesh.reset(new particle_mesh(box_size, grid_size, p3m));
+	potential_valid = false;
+}
+
+
+void generic_n_body::calculate_mesh_accelerations() {
+	/*
+	 * calculate_accelerations for the periodic particle-mesh solver. The positions are wrapped into the box first.
+	 * The potential is always taken from the mesh, as the direct energy sum is not periodic.
+	 *
+	 * Regularized pairs are not supported: the mesh would add the mutual potential of the pair on top of its internal energy
+	 * and the short range part of p3m skips the coincident members.
+	 */
+	if (regularization_radius > 0.) {
+		throw std::logic_error("generic_n_body: the particle-mesh solver does not support regularization");
+	}
+
+	int n = body_list.size();
+	last_acceleration.resize(n);
+	partner.resize(n, -1);
+
+	std::vector<double> x (n), y (n), z (n), mass (n), ax (n), ay (n), az (n);
+	for (int i=0; i<n; i++) {
+		body_list[i].position = cartesian_vector(mesh->wrap(body_list[i].position.x), mesh->wrap(body_list[i].position.y), mesh->wrap(body_list[i].position.z));
+		x[i] = body_list[i].position.x; y[i] = body_list[i].position.y; z[i] = body_list[i].position.z;
+		mass[i] = body_list[i].mass;
+	}
+
+	for (unsigned int i=0; i<test_particles.size(); i++) {
+		test_particles.x[i] = mesh->wrap(test_particles.x[i]);
+		test_particles.y[i] = mesh->wrap(test_particles.y[i]);
+		test_particles.z[i] = mesh->wrap(test_particles.z[i]);
+	}
+
+	mesh->assign(body_list);
+
+	if (potential_requested) { last_potential.resize(n); }
+	mesh->accelerations(n, x.data(), y.data(), z.data(), ax.data(), ay.data(), az.data(), potential_requested ? last_potential.data() : nullptr, mass.data());
+
+	for (int i=0; i<n; i++) { last_acceleration[i] = cartesian_vector(ax[i], ay[i], az[i]); }
+	potential_valid = potential_requested;
+
+	mesh->accelerations(test_particles.size(), test_particles.x.data(), test_particles.y.data(), test_particles.z.data(),
+			test_particles.ax.data(), test_particles.ay.data(), test_particles.az.data(), nullptr, nullptr);
 }
 
 
@@ -127,31 +254,41 @@ void generic_n_body::simulate(double final_time, double time_step, double output
 	 * Use time_step as the constant time step if adaptive_steps is false or as the initial guess for the time step if adaptive_steps is true.
 	 *
 	 * If output_time is non zero, the current state is only written to the file every output_time (the time step is adjusted if necessary).
+	 *
+	 * The total energy is only calculated if it is required, i.e. on output steps or for the adaptive time step control.
 	 */
 
 	// reopen output file in append mode
 	output_file.open(output_file_name, std::ios::out | std::ios::app);
 	//std::cout << output_file_name << std::endl;
 
+	potential_requested = adaptive_steps || output_time == 0;
 	calculate_accelerations();
 
 	unsigned int output_counter = 1;
+	unsigned long step_counter = 0;
 	double dt = time_step; // this is a copy of the time_step, it is required to keep one, so that we can go back to the original time step if it was changed by the if clause that makes sure, that no output steps are missed
 
 
 	while (time < final_time) {
 
+		if (regularization_radius > 0.) { update_regularized_pairs(); }
+
+		bool output_step = (output_time == 0) || (time == output_counter * output_time);
 
-		// adjust the time step (this implicitly calculates the total energy, therefore it is calculated in the static case explicitly), if necessary
+		// adjust the time step (this implicitly calculates the total energy, therefore it is calculated in the static case explicitly on output steps), if necessary
 		// for adaptive time steps: limit the time step in the range [1e-10:1]
 		if (adaptive_steps) { time_step = std::min(std::max(time_step_correction_factor()*time_step, 1e-10), 1.); }
-		else { calculate_total_energy(); time_step = dt; }
+		else {
+			if (output_step) { calculate_total_energy(); }
+			time_step = dt;
+		}
 
 
 		// dump output if the correct time is reached
 		if (output_time != 0) {
 			// perform the output
-			if ( time == output_counter * output_time ) {
+			if (output_step) {
 				write_state();
 				output_counter ++;
 			}
@@ -162,8 +299,21 @@ void generic_n_body::simulate(double final_time, double time_step, double output
 		}
 		else { write_state(); }
 
+		// live output, the publisher never waits for its readers
+		if (state_output != nullptr && step_counter++ % std::max(publish_interval, 1u) == 0) {
+			if (regularized_pairs.empty()) { state_output->publish(time, total_energy, body_list); }
+			else { state_output->publish(time, total_energy, physical_bodies()); }
+		}
+
+		// let the force calculation at the end of the step accumulate the potential, if the energy is needed in the next iteration
+		potential_requested = adaptive_steps || output_time == 0 || (time + time_step == output_counter * output_time);
+
+		// the perturbations of the regularized pairs are evaluated at the beginning of the step
+		std::vector<cartesian_vector> perturbations = pair_perturbations();
+
 		// perform the integration here
 		step(time_step);
+		advance_regularized_pairs(time_step, perturbations);
 
 		time += time_step;
 	}
@@ -175,6 +325,131 @@ void generic_n_body::simulate(double final_time, double time_step, double output
 
 
 
+void generic_n_body::update_regularized_pairs() {
+	/*
+	 * Dissolves regularized pairs that separated (more than twice the regularization radius) or became unbound
+	 * and forms new pairs from bound bodies closer than the regularization radius.
+	 * The accelerations are recalculated if any body was moved.
+	 */
+
+	int n = body_list.size();
+	partner.resize(n, -1);
+	bool changed = false;
+
+	for (unsigned int k=regularized_pairs.size(); k-- > 0; ) {
+		if (regularized_pairs[k].separation() > 2.*regularization_radius || regularized_pairs[k].binding_energy() >= 0.) {
+			dissolve_pair(k, body_list);
+			partner[regularized_pairs[k].first] = -1;
+			partner[regularized_pairs[k].second] = -1;
+			regularized_pairs.erase(regularized_pairs.begin() + k);
+			changed = true;
+		}
+	}
+
+	const double radius_squared = regularization_radius*regularization_radius;
+
+	for (int i=0; i<n; i++) {
+		if (partner[i] >= 0) { continue; }
+
+		for (int j=i+1; j<n; j++) {
+			if (partner[j] >= 0) { continue; }
+
+			cartesian_vector relative_position = body_list[j].position - body_list[i].position;
+			if (relative_position.norm_squared() > radius_squared) { continue; }
+
+			double total_mass = body_list[i].mass + body_list[j].mass;
+			cartesian_vector relative_velocity = body_list[j].velocity - body_list[i].velocity;
+			if (total_mass <= 0. || .5*(relative_velocity*relative_velocity) - total_mass/relative_position.norm() >= 0.) { continue; }
+
+			regularized_pairs.push_back(ks_pair(i, j, body_list[i].mass, body_list[j].mass, relative_position, relative_velocity));
+
+			// both members move with the center of mass from now on
+			cartesian_vector center_position = (body_list[i].mass*body_list[i].position + body_list[j].mass*body_list[j].position) / total_mass;
+			cartesian_vector center_velocity = (body_list[i].mass*body_list[i].velocity + body_list[j].mass*body_list[j].velocity) / total_mass;
+			body_list[i].position = center_position; body_list[j].position = center_position;
+			body_list[i].velocity = center_velocity; body_list[j].velocity = center_velocity;
+
+			partner[i] = j;
+			partner[j] = i;
+			changed = true;
+			break;
+		}
+	}
+
+	if (changed) { calculate_accelerations(); }
+}
+
+
+void generic_n_body::dissolve_pair(unsigned int pair_index, std::vector<body> & bodies) {
+	/*
+	 * Moves the members of the pair from the center of mass to their physical positions and velocities in bodies.
+	 */
+	const ks_pair & pair = regularized_pairs[pair_index];
+	double total_mass = pair.first_mass + pair.second_mass;
+
+	cartesian_vector relative_position = pair.relative_position();
+	cartesian_vector relative_velocity = pair.relative_velocity();
+	cartesian_vector center_position = bodies[pair.first].position;
+	cartesian_vector center_velocity = bodies[pair.first].velocity;
+
+	bodies[pair.first].position = center_position - (pair.second_mass/total_mass) * relative_position;
+	bodies[pair.second].position = center_position + (pair.first_mass/total_mass) * relative_position;
+	bodies[pair.first].velocity = center_velocity - (pair.second_mass/total_mass) * relative_velocity;
+	bodies[pair.second].velocity = center_velocity + (pair.first_mass/total_mass) * relative_velocity;
+}
+
+
+std::vector<body> generic_n_body::physical_bodies() {
+	/*
+	 * Copy of the body list with the members of all regularized pairs at their physical positions.
+	 */
+	std::vector<body> bodies = body_list;
+	for (unsigned int k=0; k<regularized_pairs.size(); k++) { dissolve_pair(k, bodies); }
+	return bodies;
+}
+
+
+std::vector<cartesian_vector> generic_n_body::pair_perturbations() {
+	/*
+	 * Relative acceleration of the members of every regularized pair due to all other bodies (the tidal perturbation),
+	 * evaluated at the physical positions of the members.
+	 */
+	std::vector<cartesian_vector> perturbations (regularized_pairs.size());
+	int n = body_list.size();
+
+	for (unsigned int k=0; k<regularized_pairs.size(); k++) {
+		const ks_pair & pair = regularized_pairs[k];
+		double total_mass = pair.first_mass + pair.second_mass;
+
+		cartesian_vector relative_position = pair.relative_position();
+		cartesian_vector first_position = body_list[pair.first].position - (pair.second_mass/total_mass) * relative_position;
+		cartesian_vector second_position = body_list[pair.second].position + (pair.first_mass/total_mass) * relative_position;
+
+		cartesian_vector perturbation (0., 0., 0.);
+		for (int j=0; j<n; j++) {
+			if (j == pair.first || j == pair.second) { continue; }
+
+			cartesian_vector to_first = body_list[j].position - first_position;
+			cartesian_vector to_second = body_list[j].position - second_position;
+			perturbation += (body_list[j].mass/pow(to_second.norm_squared(), 1.5)) * to_second;
+			perturbation -= (body_list[j].mass/pow(to_first.norm_squared(), 1.5)) * to_first;
+		}
+		perturbations[k] = perturbation;
+	}
+
+	return perturbations;
+}
+
+
+void generic_n_body::advance_regularized_pairs(double time_step, const std::vector<cartesian_vector> & perturbations) {
+	for (unsigned int k=0; k<regularized_pairs.size(); k++) {
+		regularized_pairs[k].advance(time_step, perturbations[k]);
+	}
+}
+
+
+
+
 void leapfrog_n_body::step(double time_step) {
 
 	//std::cout << time_step << std::endl;
@@ -184,17 +459,17 @@ void leapfrog_n_body::step(double time_step) {
 		body_list[i].position += body_list[i].velocity * time_step + .5*time_step*time_step * last_acceleration[i];
 		body_list[i].velocity += .5*time_step * last_acceleration[i];
 	}
+	test_particles.drift_accelerated(time_step);
+	test_particles.kick(.5*time_step);
 
+	// the accelerations at the new positions are also the ones required at the beginning of the next step
 	calculate_accelerations();
 
 	// update second half of the velocities
 	for (unsigned int i=0; i<body_list.size(); i++) {
 		body_list[i].velocity += .5*time_step * last_acceleration[i];
 	}
-	calculate_accelerations();
-
-
-
+	test_particles.kick(.5*time_step);
 
 }
 
@@ -217,6 +492,8 @@ void rk2_n_body::step(double time_step) {
 		body_list[i].position += temp_position_change[i];
 
 	}
+	test_particles.predict(time_step);
+	test_particles.drift(.5*time_step);
 
 	calculate_accelerations();
 
@@ -227,5 +504,8 @@ void rk2_n_body::step(double time_step) {
 		body_list[i].position -= temp_position_change[i];
 		body_list[i].position += final_position_change[i];
 	}
+	test_particles.kick(time_step);
+	test_particles.accept_prediction();
+
 	calculate_accelerations();
 }
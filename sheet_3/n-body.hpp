@@ -4,9 +4,14 @@
 
 #include "vector.hpp"
 #include "body.hpp"
+#include "test_particles.hpp"
+#include "ks_regularization.hpp"
+#include "particle_mesh.hpp"
+#include "shared_state.hpp"
 
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <vector>
 
 /*
@@ -14,15 +19,44 @@
  *
  * Objects are abstracted via the body class and stored in a std::vector container. You can add new objects using the add_object(body) function
  *
+ * Massless test particles can be added using add_test_particle(position, velocity), they are only accelerated by the bodies
+ * and are written to the output file after all bodies.
+ *
+ * By default the force calculation also accumulates the potential of every body whenever the total energy is required afterwards,
+ * so that calculate_total_energy only costs O(N). use_fused_potential(false) restores the separate O(N^2) energy loop.
+ *
+ * enable_regularization(close_radius) treats bound pairs closer than close_radius as a subsystem: both members are kept at the
+ * center of mass of the pair (the rest of the system sees a point mass) and their relative motion is integrated with the
+ * Kustaanheimo-Stiefel regularization (see ks_regularization.hpp). The pair is dissolved again, if its separation exceeds
+ * twice the close_radius. Thereby a close binary does not force the global time step down.
+ *
+ * use_particle_mesh(box_size, grid_size, p3m) replaces the direct summation by the periodic particle-mesh solver
+ * (see particle_mesh.hpp), all positions are then wrapped into the box [0, box_size)^3. It cannot be combined with
+ * enable_regularization (std::logic_error).
+ *
+ * attach_publisher(publisher, interval) publishes the bodies every interval steps to a shared memory ring (see shared_state.hpp),
+ * so that other processes can follow the simulation while it runs. The energy of a frame is the last calculated total energy.
+ *
+ * calculate_accelerations, calculate_total_energy and write_state are virtual, so that distributed_n_body (see distributed_n_body.hpp)
+ * can run any of the integrators on a spatially decomposed system.
+ *
  */
 class generic_n_body {
 	public:
 		// constructor
 		generic_n_body (double time, std::string out_file_name);
+		virtual ~generic_n_body() { }
 
 		void add_object(body object);
+		void add_test_particle(cartesian_vector position, cartesian_vector velocity);
+		void add_objects(const std::vector<body> & objects);
+		void add_test_particles(const std::vector<body> & particles);
 		void simulate(double final_time, double time_step, double output_time, bool adaptive_steps);
-		void calculate_total_energy();
+		virtual void calculate_total_energy();
+		void use_fused_potential(bool fused) { fused_potential = fused; }
+		void enable_regularization(double close_radius) { regularization_radius = close_radius; }
+		void use_particle_mesh(double box_size, int grid_size, bool p3m);
+		void attach_publisher(state_publisher * publisher, unsigned int interval) { state_output = publisher; publish_interval = interval; }
 
 
 	protected:
@@ -31,11 +65,33 @@ class generic_n_body {
 		std::string output_file_name;
 		std::vector<body> body_list;
 		std::vector<cartesian_vector> last_acceleration;
+		std::vector<double> last_potential;
+		bool fused_potential = true, potential_requested = true, potential_valid = false;
+		test_particle_set test_particles;
+
+		// regularized pairs, partner contains the index of the other member for every body in a pair (-1 otherwise)
+		double regularization_radius = 0.;
+		std::vector<ks_pair> regularized_pairs;
+		std::vector<int> partner;
+
+		// periodic particle-mesh solver, direct summation if this is a nullptr
+		std::unique_ptr<particle_mesh> mesh;
+
+		// live output (not owned), nullptr if disabled
+		state_publisher * state_output = nullptr;
+		unsigned int publish_interval = 1;
 
 		double time_step_correction_factor();
 		virtual void step(double time_step) { return; }
-		void write_state();
-		void calculate_accelerations();
+		virtual void write_state();
+		virtual void calculate_accelerations();
+		void calculate_mesh_accelerations();
+
+		void update_regularized_pairs();
+		void dissolve_pair(unsigned int pair_index, std::vector<body> & bodies);
+		std::vector<cartesian_vector> pair_perturbations();
+		void advance_regularized_pairs(double time_step, const std::vector<cartesian_vector> & perturbations);
+		std::vector<body> physical_bodies();
 };
 
 /*
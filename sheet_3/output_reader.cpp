@@ -0,0 +1,265 @@
+#include "output_reader.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <omp.h>
+
+
+static const char * map_file(const std::string & file_name, std::size_t & length) {
+	/*
+	 * Maps the whole file read-only, returns a nullptr for empty files.
+	 */
+	int descriptor = open(file_name.c_str(), O_RDONLY);
+	if (descriptor < 0) { throw std::runtime_error(file_name + ": cannot open file"); }
+
+	struct stat status;
+	if (fstat(descriptor, &status) != 0) {
+		close(descriptor);
+		throw std::runtime_error(file_name + ": cannot read the file size");
+	}
+
+	length = status.st_size;
+	if (length == 0) { close(descriptor); return nullptr; }
+
+	void * mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	close(descriptor);
+	if (mapping == MAP_FAILED) { throw std::runtime_error(file_name + ": cannot map file"); }
+
+	return static_cast<const char *>(mapping);
+}
+
+
+static const char * parse_numbers(const char * begin, const char * end, std::vector<double> & values) {
+	/*
+	 * Appends all space separated numbers in [begin, end) to values, returns the position of the first invalid character
+	 * (end if the whole range was parsed).
+	 */
+	const char * position = begin;
+	while (true) {
+		while (position < end && (*position == ' ' || *position == '\t' || *position == '\r')) { position++; }
+		if (position == end) { return end; }
+
+		double value;
+		std::from_chars_result result = std::from_chars(position, end, value);
+		if (result.ec != std::errc()) { return position; }
+
+		values.push_back(value);
+		position = result.ptr;
+	}
+}
+
+
+output_reader::output_reader (const std::string & file_name) : file_name(file_name) {
+
+	data = map_file(file_name, length);
+	if (data == nullptr) { return; }
+
+	// the index is built in one sequential sweep over the mapping
+	madvise(const_cast<char *>(data), length, MADV_SEQUENTIAL);
+
+	int threads = omp_get_max_threads();
+	std::vector<std::vector<std::size_t> > chunk_offsets (threads);
+	std::vector<std::vector<double> > chunk_times (threads);
+	std::vector<std::size_t> failed (threads, length);
+
+	#pragma omp parallel num_threads(threads)
+	{
+		int thread = omp_get_thread_num(), thread_count = omp_get_num_threads();
+		std::size_t begin = length*thread/thread_count, end = length*(thread + 1)/thread_count;
+
+		// line starts in [begin, end): position 0 and every position after a newline (except the end of the file)
+		std::size_t position = begin;
+		if (position > 0) {
+			const void * newline = std::memchr(data + position - 1, '\n', end - position + 1);
+			position = (newline == nullptr) ? end : static_cast<const char *>(newline) - data + 1;
+		}
+
+		while (position < end) {
+			const char * line = data + position;
+			const char * stop = static_cast<const char *>(std::memchr(line, '\n', length - position));
+			if (stop == nullptr) { stop = data + length; }
+
+			// only the time (the first value) is parsed
+			double time;
+			std::from_chars_result result = std::from_chars(line, stop, time);
+			if (stop != line) {
+				if (result.ec != std::errc()) { failed[thread] = std::min(failed[thread], position); break; }
+				chunk_offsets[thread].push_back(position);
+				chunk_times[thread].push_back(time);
+			}
+
+			position = stop - data + 1;
+		}
+	}
+
+	std::size_t first_failure = *std::min_element(failed.begin(), failed.end());
+	if (first_failure < length) {
+		throw std::runtime_error(file_name + ": malformed snapshot at byte " + std::to_string(first_failure));
+	}
+
+	for (int t=0; t<threads; t++) {
+		offsets.insert(offsets.end(), chunk_offsets[t].begin(), chunk_offsets[t].end());
+		times.insert(times.end(), chunk_times[t].begin(), chunk_times[t].end());
+	}
+
+	madvise(const_cast<char *>(data), length, MADV_RANDOM);
+}
+
+
+output_reader::~output_reader() {
+	if (data != nullptr) { munmap(const_cast<char *>(data), length); }
+}
+
+
+std::size_t output_reader::find(double time) const {
+	// the snapshots are written in chronological order
+	return std::lower_bound(times.begin(), times.end(), time) - times.begin();
+}
+
+
+const char * output_reader::line_end(std::size_t index) const {
+	const char * line = data + offsets[index];
+	const char * stop = static_cast<const char *>(std::memchr(line, '\n', data + length - line));
+	return (stop == nullptr) ? data + length : stop;
+}
+
+
+snapshot output_reader::read(std::size_t index) const {
+	if (index >= size()) { throw std::runtime_error(file_name + ": snapshot " + std::to_string(index) + " does not exist"); }
+
+	std::vector<double> values;
+	const char * end = line_end(index);
+	if (parse_numbers(data + offsets[index], end, values) != end || values.size() < 2 || (values.size() - 2) % 6 != 0) {
+		throw std::runtime_error(file_name + ": malformed snapshot " + std::to_string(index));
+	}
+
+	snapshot result;
+	result.time = values[0];
+	result.energy = values[1];
+	result.values.assign(values.begin() + 2, values.end());
+	return result;
+}
+
+
+void output_reader::extract(std::size_t first, std::size_t last, std::size_t stride, std::ostream & stream) const {
+	/*
+	 * The lines are copied unchanged, so the extracted file is identical to the corresponding lines of the output file.
+	 */
+	last = std::min(last, size());
+	for (std::size_t index=first; index<last; index+=std::max<std::size_t>(stride, 1)) {
+		const char * end = line_end(index);
+		stream.write(data + offsets[index], end - (data + offsets[index]));
+		stream << '\n';
+	}
+}
+
+
+std::size_t output_reader::convert_to_binary(const std::string & binary_file_name, std::size_t block_size) const {
+	/*
+	 * The snapshots are parsed in parallel block by block and every block is appended to the binary file before the next
+	 * one is parsed. The pages of the converted block are released again, so the memory use does not grow with the file size.
+	 */
+	std::FILE * output = std::fopen(binary_file_name.c_str(), "wb");
+	if (output == nullptr) { throw std::runtime_error(binary_file_name + ": cannot open file"); }
+
+	std::uint32_t values_per_record = (size() == 0) ? 0 : read(0).values.size() + 2;
+	char header[64] = { 0 };
+	std::memcpy(header, "NBODYBIN", 8);
+	std::uint32_t version = 1;
+	std::uint64_t record_count = size();
+	std::memcpy(header + 8, &version, 4);
+	std::memcpy(header + 12, &values_per_record, 4);
+	std::memcpy(header + 16, &record_count, 8);
+	std::fwrite(header, 1, sizeof(header), output);
+
+	block_size = std::max<std::size_t>(block_size, 1);
+	std::vector<double> block (block_size*values_per_record);
+
+	for (std::size_t first=0; first<size(); first+=block_size) {
+		std::size_t count = std::min(block_size, size() - first);
+		long malformed = -1;
+
+		#pragma omp parallel
+		{
+			std::vector<double> values;
+			values.reserve(values_per_record);
+
+			#pragma omp for schedule(static)
+			for (std::size_t k=0; k<count; k++) {
+				values.clear();
+				const char * end = line_end(first + k);
+				if (parse_numbers(data + offsets[first + k], end, values) != end || values.size() != values_per_record) {
+					#pragma omp critical
+					malformed = std::max<long>(malformed, first + k);
+					continue;
+				}
+				std::copy(values.begin(), values.end(), block.begin() + k*values_per_record);
+			}
+		}
+
+		if (malformed >= 0) {
+			std::fclose(output);
+			throw std::runtime_error(file_name + ": snapshot " + std::to_string(malformed) + " does not have " + std::to_string(values_per_record) + " values");
+		}
+
+		std::fwrite(block.data(), sizeof(double), count*values_per_record, output);
+
+		// release the pages of the converted lines (whole pages only)
+		long page = sysconf(_SC_PAGESIZE);
+		std::size_t release_end = (first + count < size()) ? offsets[first + count] : length;
+		release_end -= release_end % page;
+		if (release_end > 0) { madvise(const_cast<char *>(data), release_end, MADV_DONTNEED); }
+	}
+
+	std::fclose(output);
+	return size();
+}
+
+
+binary_output::binary_output (const std::string & file_name) {
+
+	data = map_file(file_name, length);
+
+	std::uint32_t version = 0;
+	if (data == nullptr || length < 64 || std::memcmp(data, "NBODYBIN", 8) != 0) {
+		if (data != nullptr) { munmap(const_cast<char *>(data), length); }
+		throw std::runtime_error(file_name + ": not a binary n-body output file");
+	}
+
+	std::memcpy(&version, data + 8, 4);
+	std::memcpy(&values_per_record, data + 12, 4);
+	std::memcpy(&record_count, data + 16, 8);
+
+	if (version != 1 || length < 64 + record_count*values_per_record*sizeof(double)) {
+		munmap(const_cast<char *>(data), length);
+		throw std::runtime_error(file_name + ": unsupported version or truncated file");
+	}
+
+	values = reinterpret_cast<const double *>(data + 64);
+}
+
+
+binary_output::~binary_output() {
+	if (data != nullptr) { munmap(const_cast<char *>(data), length); }
+}
+
+
+snapshot binary_output::read(std::size_t index) const {
+	if (index >= size()) { throw std::runtime_error("binary_output: record " + std::to_string(index) + " does not exist"); }
+
+	const double * values = record(index);
+	snapshot result;
+	result.time = values[0];
+	result.energy = values[1];
+	result.values.assign(values + 2, values + values_per_record);
+	return result;
+}
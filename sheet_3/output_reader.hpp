@@ -0,0 +1,101 @@
+/* FILE OUTPUT_READER.HPP */
+#ifndef FILE_OUTPUT_READER_HPP
+#define FILE_OUTPUT_READER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/*
+ * Random access to the text output of generic_n_body::write_state (one snapshot per line: time energy position1 velocity1 ...).
+ *
+ * The file is memory mapped, the constructor builds an index of the snapshots (start offset and time of every line) in one
+ * parallel pass over the file: every thread searches the line starts in its part of the file and parses their times.
+ * The index costs 16 bytes per snapshot, the snapshots themselves are only parsed (with std::from_chars) when they are requested.
+ *
+ *	output_reader reader ("task_c.dat");
+ *	snapshot state = reader.read(reader.find(25.));   // first snapshot at or after t = 25
+ *	reader.extract(0, reader.size(), 10, std::cout);   // every 10th snapshot as text
+ *	reader.convert_to_binary("task_c.bin");           // see below
+ *
+ * Errors (missing file, malformed lines, lines with a different number of values) throw std::runtime_error.
+ *
+ * Binary format (written by convert_to_binary, read by binary_output):
+ *	header (64 bytes): char magic[8] = "NBODYBIN", uint32 version = 1, uint32 values per record,
+ *	                   uint64 record count, zero padding
+ *	records:           values per record doubles each (time, energy, x y z vx vy vz of every body and test particle)
+ * All numbers are stored in the byte order of the machine that wrote the file (little endian on x86).
+ * A record is found at 64 + index*values*8 bytes, so the binary file needs no index.
+ */
+
+class snapshot {
+	public:
+		double time, energy;
+
+		// position and velocity of all bodies: x y z vx vy vz for every body
+		std::vector<double> values;
+
+		unsigned int body_count() const { return values.size()/6; }
+};
+
+
+class output_reader {
+	public:
+		output_reader (const std::string & file_name);
+		~output_reader();
+
+		output_reader (const output_reader &) = delete;
+		output_reader & operator = (const output_reader &) = delete;
+
+		std::size_t size() const { return offsets.size(); }
+		double time(std::size_t index) const { return times[index]; }
+
+		// index of the first snapshot at or after the given time (size() if there is none)
+		std::size_t find(double time) const;
+
+		snapshot read(std::size_t index) const;
+
+		// writes the snapshots first, first + stride, ... (before last) in the original text format
+		void extract(std::size_t first, std::size_t last, std::size_t stride, std::ostream & stream) const;
+
+		// converts the whole file to the binary format in blocks of block_size snapshots (parsed in parallel), returns the number of records
+		std::size_t convert_to_binary(const std::string & binary_file_name, std::size_t block_size = 4096) const;
+
+	private:
+		const char * data = nullptr;
+		std::size_t length = 0;
+		std::string file_name;
+
+		// start offset and time of every snapshot
+		std::vector<std::size_t> offsets;
+		std::vector<double> times;
+
+		const char * line_end(std::size_t index) const;
+};
+
+
+class binary_output {
+	public:
+		binary_output (const std::string & file_name);
+		~binary_output();
+
+		binary_output (const binary_output &) = delete;
+		binary_output & operator = (const binary_output &) = delete;
+
+		std::size_t size() const { return record_count; }
+		snapshot read(std::size_t index) const;
+
+		// pointer to the values of the record (time, energy, positions and velocities), valid as long as the object exists
+		const double * record(std::size_t index) const { return values + index*values_per_record; }
+
+	private:
+		const char * data = nullptr;
+		std::size_t length = 0;
+		const double * values = nullptr;
+		std::uint32_t values_per_record = 0;
+		std::uint64_t record_count = 0;
+};
+
+#endif /* FILE_OUTPUT_READER_HPP */
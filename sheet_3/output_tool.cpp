@@ -0,0 +1,77 @@
+#include "output_reader.hpp"
+
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+/*
+ * Command line interface of output_reader.hpp:
+ *
+ *	./output_tool.out info FILE                     number of snapshots, time range and number of bodies
+ *	./output_tool.out snapshot FILE TIME            the first snapshot at or after TIME
+ *	./output_tool.out range FILE FROM TO [STRIDE]   every STRIDE-th snapshot with FROM <= time < TO
+ *	./output_tool.out convert FILE BINARY_FILE      converts the text output to the binary format
+ *	./output_tool.out binary BINARY_FILE INDEX      prints a record of a binary file in the text format
+ *
+ * The snapshots are printed in the text format of generic_n_body::write_state.
+ */
+
+static void print(const snapshot & state) {
+	std::cout << state.time << ' ' << state.energy << ' ';
+	for (unsigned int k=0; k<state.values.size(); k++) { std::cout << state.values[k] << ' '; }
+	std::cout << std::endl;
+}
+
+
+int main(int argc, char **argv) {
+	std::string command = (argc > 1) ? argv[1] : "";
+
+	if (!((command == "info" && argc == 3) || (command == "snapshot" && argc == 4) || (command == "range" && (argc == 5 || argc == 6))
+			|| (command == "convert" && argc == 4) || (command == "binary" && argc == 4))) {
+		std::cerr << "Usage: ./output_tool.out info FILE | snapshot FILE TIME | range FILE FROM TO [STRIDE]"
+			<< " | convert FILE BINARY_FILE | binary BINARY_FILE INDEX" << std::endl;
+		return 1;
+	}
+
+	std::cout << std::setprecision(14);
+
+	try {
+		if (command == "binary") {
+			binary_output binary (argv[2]);
+			print(binary.read(std::strtoul(argv[3], nullptr, 10)));
+			return 0;
+		}
+
+		output_reader reader (argv[2]);
+
+		if (command == "info") {
+			std::cout << reader.size() << " snapshots";
+			if (reader.size() > 0) {
+				std::cout << " from t = " << reader.time(0) << " to t = " << reader.time(reader.size() - 1)
+					<< ", " << reader.read(0).body_count() << " bodies";
+			}
+			std::cout << std::endl;
+		}
+		else if (command == "snapshot") {
+			std::size_t index = reader.find(std::atof(argv[3]));
+			if (index == reader.size()) { std::cerr << "no snapshot at or after t = " << argv[3] << std::endl; return 1; }
+			reader.extract(index, index + 1, 1, std::cout);
+		}
+		else if (command == "range") {
+			std::size_t stride = (argc == 6) ? std::strtoul(argv[5], nullptr, 10) : 1;
+			reader.extract(reader.find(std::atof(argv[3])), reader.find(std::atof(argv[4])), stride, std::cout);
+		}
+		else {
+			std::size_t records = reader.convert_to_binary(argv[3]);
+			std::cout << records << " snapshots written to " << argv[3] << std::endl;
+		}
+	}
+	catch (std::exception & error) {
+		std::cerr << error.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,293 @@
+#include "particle_mesh.hpp"
+#include "gravity_kernel.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+static const double pi = 3.141592653589793;
+
+
+particle_mesh::particle_mesh (double box_size, int grid_size, bool p3m)
+	: box_size(box_size), cell_size(box_size/grid_size), grid_size(grid_size), p3m(p3m), fft(grid_size), cells(1) {
+
+	split_scale = 1.25*cell_size;
+	cutoff = 4.5*split_scale;
+
+	if (!p3m) { self_kernel_for_unit_mass(); }
+}
+
+
+double particle_mesh::wrap(double coordinate) const {
+	coordinate -= box_size*std::floor(coordinate/box_size);
+
+	// rounding might map tiny negative values onto box_size
+	return (coordinate < box_size) ? coordinate : 0.;
+}
+
+
+static void cic_weights(double scaled, int grid_size, int & lower, int & upper, double & upper_weight) {
+	/*
+	 * Cloud-in-cell weights of a wrapped coordinate in units of the mesh cells: (1 - upper_weight) for lower and upper_weight for upper.
+	 */
+	lower = std::min((int) scaled, grid_size - 1);
+	upper_weight = scaled - lower;
+	upper = (lower + 1 == grid_size) ? 0 : lower + 1;
+}
+
+
+static double potential_factor(double kx, double ky, double kz, double cell_size, double split_scale, bool p3m) {
+	/*
+	 * phi_k/rho_k: -4 pi/k^2, for p3m multiplied with the long range filter exp(-k^2 r_s^2) and divided by the squared window
+	 * function of the cloud-in-cell assignment and interpolation (without the filter the deconvolution would amplify the
+	 * noise close to the Nyquist frequency)
+	 */
+	double k_squared = kx*kx + ky*ky + kz*kz;
+	if (k_squared == 0.) { return 0.; }
+
+	double factor = -4.*pi/k_squared;
+	if (!p3m) { return factor; }
+
+	double window = 1.;
+	double half_cell[3] = { .5*kx*cell_size, .5*ky*cell_size, .5*kz*cell_size };
+	for (int c=0; c<3; c++) {
+		if (half_cell[c] != 0.) { window *= std::sin(half_cell[c])/half_cell[c]; }
+	}
+	window *= window;
+
+	return factor*std::exp(-k_squared*split_scale*split_scale) / (window*window);
+}
+
+
+void particle_mesh::self_kernel_for_unit_mass() {
+	/*
+	 * The density of a unit mass at mesh point 0 is 1/cell volume there, its transform is that constant for every k.
+	 */
+	const int n = grid_size;
+	const double k_unit = 2.*pi/box_size;
+	std::vector<std::complex<double> > potential ((long) n*n*n);
+
+	for (int i=0; i<n; i++) {
+		for (int j=0; j<n; j++) {
+			for (int k=0; k<n; k++) {
+				double kx = k_unit * ((i < n/2) ? i : i - n);
+				double ky = k_unit * ((j < n/2) ? j : j - n);
+				double kz = k_unit * ((k < n/2) ? k : k - n);
+				potential[index(i, j, k)] = potential_factor(kx, ky, kz, cell_size, split_scale, p3m)/(cell_size*cell_size*cell_size);
+			}
+		}
+	}
+	fft.inverse(potential);
+
+	for (int a=-1; a<=1; a++) {
+		for (int b=-1; b<=1; b++) {
+			for (int c=-1; c<=1; c++) {
+				self_kernel[(a + 1)*9 + (b + 1)*3 + c + 1] = potential[index((a + n) % n, (b + n) % n, (c + n) % n)].real();
+			}
+		}
+	}
+}
+
+
+void particle_mesh::assign(const std::vector<body> & sources) {
+
+	const int n = grid_size;
+	const long total = (long) n*n*n;
+	const int n_sources = sources.size();
+
+	// cloud-in-cell mass assignment
+	std::vector<std::complex<double> > density (total);
+	double * density_values = reinterpret_cast<double *>(density.data());
+	const double inverse_volume = 1./(cell_size*cell_size*cell_size);
+
+	#pragma omp parallel for schedule(static)
+	for (int s=0; s<n_sources; s++) {
+		int i[2], j[2], k[2];
+		double wx, wy, wz;
+		cic_weights(wrap(sources[s].position.x)/cell_size, n, i[0], i[1], wx);
+		cic_weights(wrap(sources[s].position.y)/cell_size, n, j[0], j[1], wy);
+		cic_weights(wrap(sources[s].position.z)/cell_size, n, k[0], k[1], wz);
+
+		double weight_x[2] = { 1. - wx, wx }, weight_y[2] = { 1. - wy, wy }, weight_z[2] = { 1. - wz, wz };
+		double density_scale = sources[s].mass * inverse_volume;
+
+		for (int a=0; a<2; a++) {
+			for (int b=0; b<2; b++) {
+				for (int c=0; c<2; c++) {
+					// real part of the complex grid value
+					#pragma omp atomic
+					density_values[2*index(i[a], j[b], k[c])] += density_scale * weight_x[a]*weight_y[b]*weight_z[c];
+				}
+			}
+		}
+	}
+
+	fft.forward(density);
+
+	// potential in Fourier space (see potential_factor)
+	std::vector<std::complex<double> > & potential_k = density;
+	const double k_unit = 2.*pi/box_size;
+
+	#pragma omp parallel for schedule(static)
+	for (int i=0; i<n; i++) {
+		for (int j=0; j<n; j++) {
+			for (int k=0; k<n; k++) {
+				double kx = k_unit * ((i < n/2) ? i : i - n);
+				double ky = k_unit * ((j < n/2) ? j : j - n);
+				double kz = k_unit * ((k < n/2) ? k : k - n);
+				potential_k[index(i, j, k)] *= potential_factor(kx, ky, kz, cell_size, split_scale, p3m);
+			}
+		}
+	}
+
+	// acceleration a = -grad phi, i.e. a_k = -i k phi_k (the Nyquist frequency has no well defined derivative)
+	std::vector<double> * fields[4] = { &mesh_ax, &mesh_ay, &mesh_az, &mesh_potential };
+	std::vector<std::complex<double> > work (total);
+
+	for (int component=0; component<4; component++) {
+
+		#pragma omp parallel for schedule(static)
+		for (int i=0; i<n; i++) {
+			for (int j=0; j<n; j++) {
+				for (int k=0; k<n; k++) {
+					long m = index(i, j, k);
+					if (component == 3) { work[m] = potential_k[m]; continue; }
+
+					int mode = (component == 0) ? i : ((component == 1) ? j : k);
+					double wave_number = (mode == n/2) ? 0. : k_unit * ((mode < n/2) ? mode : mode - n);
+					work[m] = std::complex<double>(0., -wave_number) * potential_k[m];
+				}
+			}
+		}
+
+		fft.inverse(work);
+
+		std::vector<double> & field = *fields[component];
+		field.resize(total);
+
+		#pragma omp parallel for schedule(static)
+		for (long m=0; m<total; m++) { field[m] = work[m].real(); }
+	}
+
+	if (!p3m) { return; }
+
+	// cell list for the short range part: cells of at least the cutoff length, a single cell if the box is too small for 3 cells
+	cells = (int) (box_size/cutoff);
+	if (cells < 3) { cells = 1; }
+	const int cell_count = cells*cells*cells;
+
+	std::vector<int> cell_of (n_sources);
+	cell_start.assign(cell_count + 1, 0);
+
+	for (int s=0; s<n_sources; s++) {
+		int cx = std::min((int) (wrap(sources[s].position.x)/box_size*cells), cells - 1);
+		int cy = std::min((int) (wrap(sources[s].position.y)/box_size*cells), cells - 1);
+		int cz = std::min((int) (wrap(sources[s].position.z)/box_size*cells), cells - 1);
+		cell_of[s] = (cx*cells + cy)*cells + cz;
+		cell_start[cell_of[s] + 1]++;
+	}
+	for (int c=0; c<cell_count; c++) { cell_start[c+1] += cell_start[c]; }
+
+	source_x.resize(n_sources); source_y.resize(n_sources); source_z.resize(n_sources); source_mass.resize(n_sources);
+	std::vector<int> fill (cell_start.begin(), cell_start.end() - 1);
+	for (int s=0; s<n_sources; s++) {
+		int target = fill[cell_of[s]]++;
+		source_x[target] = wrap(sources[s].position.x);
+		source_y[target] = wrap(sources[s].position.y);
+		source_z[target] = wrap(sources[s].position.z);
+		source_mass[target] = sources[s].mass;
+	}
+}
+
+
+void particle_mesh::short_range(double x, double y, double z, double & ax, double & ay, double & az, double & potential) const {
+	/*
+	 * Adds the short range part of the split force from all sources within the cutoff (minimum image convention).
+	 */
+	const double cutoff_squared = cutoff*cutoff;
+	const double inverse_sqrt_pi = 1./std::sqrt(pi);
+
+	int cx = std::min((int) (x/box_size*cells), cells - 1);
+	int cy = std::min((int) (y/box_size*cells), cells - 1);
+	int cz = std::min((int) (z/box_size*cells), cells - 1);
+	int range = (cells == 1) ? 0 : 1;
+
+	for (int a=-range; a<=range; a++) {
+		for (int b=-range; b<=range; b++) {
+			for (int c=-range; c<=range; c++) {
+				int cell = (((cx + a + cells) % cells)*cells + (cy + b + cells) % cells)*cells + (cz + c + cells) % cells;
+
+				for (int s=cell_start[cell]; s<cell_start[cell+1]; s++) {
+					double dx = source_x[s] - x, dy = source_y[s] - y, dz = source_z[s] - z;
+					dx -= box_size*std::round(dx/box_size);
+					dy -= box_size*std::round(dy/box_size);
+					dz -= box_size*std::round(dz/box_size);
+
+					double distance_squared = dx*dx + dy*dy + dz*dz;
+					if (distance_squared == 0. || distance_squared > cutoff_squared) { continue; }
+
+					double pair_potential;
+					double factor = direct_kernel(dx, dy, dz, source_mass[s], pair_potential);
+
+					double u = .5*std::sqrt(distance_squared)/split_scale;
+					double complementary = std::erfc(u);
+					factor *= complementary + 2.*u*inverse_sqrt_pi*std::exp(-u*u);
+
+					ax += factor*dx; ay += factor*dy; az += factor*dz;
+					potential += complementary*pair_potential;
+				}
+			}
+		}
+	}
+}
+
+
+void particle_mesh::accelerations(int n, const double * x, const double * y, const double * z, double * ax, double * ay, double * az,
+		double * potential, const double * self_mass) const {
+
+	// the long range potential of a point mass at its own position is -m/(r_s sqrt(pi))
+	const double self_potential_factor = 1./(split_scale*std::sqrt(pi));
+
+	#pragma omp parallel for schedule(static)
+	for (int p=0; p<n; p++) {
+		double px = wrap(x[p]), py = wrap(y[p]), pz = wrap(z[p]);
+
+		int i[2], j[2], k[2];
+		double wx, wy, wz;
+		cic_weights(px/cell_size, grid_size, i[0], i[1], wx);
+		cic_weights(py/cell_size, grid_size, j[0], j[1], wy);
+		cic_weights(pz/cell_size, grid_size, k[0], k[1], wz);
+		double weight_x[2] = { 1. - wx, wx }, weight_y[2] = { 1. - wy, wy }, weight_z[2] = { 1. - wz, wz };
+
+		double acc_x = 0., acc_y = 0., acc_z = 0., phi = 0.;
+		for (int a=0; a<2; a++) {
+			for (int b=0; b<2; b++) {
+				for (int c=0; c<2; c++) {
+					long m = index(i[a], j[b], k[c]);
+					double weight = weight_x[a]*weight_y[b]*weight_z[c];
+					acc_x += weight*mesh_ax[m]; acc_y += weight*mesh_ay[m]; acc_z += weight*mesh_az[m];
+					phi += weight*mesh_potential[m];
+				}
+			}
+		}
+
+		if (p3m) {
+			short_range(px, py, pz, acc_x, acc_y, acc_z, phi);
+			if (self_mass != nullptr) { phi += self_mass[p]*self_potential_factor; }
+		}
+		else if (self_mass != nullptr) {
+			// the mass is spread over and read from the same 8 mesh points, pairs of them are 0 or 1 points apart per axis
+			double self_phi = 0.;
+			for (int a=0; a<8; a++) {
+				for (int b=0; b<8; b++) {
+					int offset = (((b >> 2) - (a >> 2) + 1)*3 + ((b >> 1 & 1) - (a >> 1 & 1) + 1))*3 + (b & 1) - (a & 1) + 1;
+					self_phi += weight_x[a >> 2]*weight_y[a >> 1 & 1]*weight_z[a & 1] * weight_x[b >> 2]*weight_y[b >> 1 & 1]*weight_z[b & 1]
+						* self_kernel[offset];
+				}
+			}
+			phi -= self_mass[p]*self_phi;
+		}
+
+		ax[p] = acc_x; ay[p] = acc_y; az[p] = acc_z;
+		if (potential != nullptr) { potential[p] = phi; }
+	}
+}
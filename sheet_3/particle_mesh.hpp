@@ -0,0 +1,65 @@
+/* FILE PARTICLE_MESH.HPP */
+#ifndef FILE_PARTICLE_MESH_HPP
+#define FILE_PARTICLE_MESH_HPP
+
+#include "body.hpp"
+#include "fft.hpp"
+
+#include <complex>
+#include <vector>
+
+/*
+ * Particle-mesh gravity solver for a periodic cubic box [0, box_size)^3 (G = 1).
+ *
+ * assign() distributes the masses onto a grid_size^3 mesh with cloud-in-cell weights, solves the Poisson equation
+ * nabla^2 phi = 4 pi (rho - <rho>) with FFTs (the mean density is removed, as usual for periodic boxes) and differentiates
+ * the potential in Fourier space. accelerations() interpolates the mesh acceleration and potential back to arbitrary points,
+ * again with cloud-in-cell weights. The pure mesh force is softened on the scale of a few cells.
+ *
+ * With p3m enabled the mesh only carries the long range force: the potential is split with a Gaussian of width
+ * split_scale = 1.25 mesh cells (phi_long = phi exp(-k^2 split_scale^2), the cloud-in-cell smoothing is deconvolved), and the short range remainder
+ *	a_short = m d/|d|^3 ( erfc(r/(2 r_s)) + r/(r_s sqrt(pi)) exp(-r^2/(4 r_s^2)) )
+ * is added with the direct kernel for all pairs closer than 4.5 split scales (found with a cell list, minimum image convention).
+ * Coincident points (e.g. a body and itself) are skipped.
+ *
+ * The potential of a source at its own position is removed with self_mass: with p3m the long range part -m/(r_s sqrt(pi)),
+ * without p3m the mesh potential of the source itself, which depends on its position within the cell (the cloud-in-cell
+ * weights applied twice to the mesh potential of a unit mass, tabulated for the neighbouring mesh points in the constructor).
+ */
+class particle_mesh {
+	public:
+		particle_mesh (double box_size, int grid_size, bool p3m);
+
+		// wraps a coordinate into [0, box_size)
+		double wrap(double coordinate) const;
+
+		// builds the mesh fields (and the cell list for the short range part) for the given sources
+		void assign(const std::vector<body> & sources);
+
+		// acceleration (and potential, if not a nullptr) at n points given as arrays, self_mass removes the self potential of sources
+		void accelerations(int n, const double * x, const double * y, const double * z, double * ax, double * ay, double * az,
+				double * potential, const double * self_mass) const;
+
+	private:
+		double box_size, cell_size, split_scale, cutoff;
+		int grid_size;
+		bool p3m;
+		fft_3d fft;
+
+		// real space fields on the mesh: acceleration components and potential
+		std::vector<double> mesh_ax, mesh_ay, mesh_az, mesh_potential;
+
+		// copy of the sources sorted by cells of the short range cell list (cell_start has cells^3 + 1 entries)
+		int cells;
+		std::vector<int> cell_start;
+		std::vector<double> source_x, source_y, source_z, source_mass;
+
+		// pure mesh: potential at the mesh points with offsets -1..1 from a unit mass assigned to one mesh point
+		double self_kernel[27];
+
+		long index(int i, int j, int k) const { return ((long) i*grid_size + j)*grid_size + k; }
+		void short_range(double x, double y, double z, double & ax, double & ay, double & az, double & potential) const;
+		void self_kernel_for_unit_mass();
+};
+
+#endif /* FILE_PARTICLE_MESH_HPP */
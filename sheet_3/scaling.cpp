@@ -0,0 +1,79 @@
+#include "distributed_n_body.hpp"
+#include "initial_conditions.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <omp.h>
+
+/*
+ * Scaling benchmark of the distributed mode (see distributed_n_body.hpp).
+ *
+ * Usage: mpirun -np P ./scaling.out strong|weak N steps [opening_angle]
+ *
+ *	strong: a Plummer sphere with N bodies in total, independent of P
+ *	weak:   a Plummer sphere with N bodies per process (P*N in total)
+ *
+ * The root process prints one line: processes, threads per process, bodies, steps, wall clock time per step,
+ * the fractions of the time spent in the exchanges and the force loop (maximum over the processes), the average number
+ * of ghosts received per force calculation and process, the number of rebalances and the relative energy error.
+ * The make targets strong_scaling and weak_scaling run the benchmark for 1, 2, 4 and 8 processes.
+ */
+int main(int argc, char **argv) {
+	MPI_Init(&argc, &argv);
+
+	int rank, processes;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &processes);
+
+	if (argc != 4 && argc != 5) {
+		if (rank == 0) { std::cerr << "Usage: mpirun -np P ./scaling.out strong|weak N steps [opening_angle]" << std::endl; }
+		MPI_Finalize();
+		return 1;
+	}
+
+	std::string mode = argv[1];
+	unsigned int count = std::atoi(argv[2]);
+	int steps = std::atoi(argv[3]);
+	double opening_angle = (argc == 5) ? std::atof(argv[4]) : .5;
+	if (mode == "weak") { count *= processes; }
+
+	const double time_step = 1e-3;
+
+	// every process generates the same initial conditions
+	std::vector<body> bodies;
+	plummer_sphere(bodies, count, 1., 1., 42);
+
+	distributed_n_body<leapfrog_n_body> solver (0., "scaling.dat", MPI_COMM_WORLD, opening_angle);
+	solver.add_objects(bodies);
+
+	solver.calculate_total_energy();
+	double initial_energy = solver.energy();
+
+	// only the steps are measured
+	domain_decomposition & domains = solver.decomposition();
+	domains.communication_time = 0.; domains.computation_time = 0.;
+	domains.force_count = 0; domains.ghost_count = 0;
+
+	MPI_Barrier(MPI_COMM_WORLD);
+	double start = MPI_Wtime();
+	solver.simulate(steps*time_step, time_step, steps*time_step, false);
+	double elapsed = MPI_Wtime() - start;
+
+	double fractions[2] = { domains.communication_time/elapsed, domains.computation_time/elapsed }, largest[2];
+	MPI_Reduce(fractions, largest, 2, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+	double ghosts = domains.total((double) domains.ghost_count);
+
+	solver.calculate_total_energy();
+	double final_energy = solver.energy();
+
+	if (rank == 0) {
+		std::cout << processes << ' ' << omp_get_max_threads() << ' ' << count << ' ' << steps << ' ' << elapsed/steps << ' '
+			<< largest[0] << ' ' << largest[1] << ' ' << ghosts/processes/domains.force_count << ' ' << domains.rebalance_count << ' '
+			<< (final_energy - initial_energy)/initial_energy << std::endl;
+	}
+
+	MPI_Finalize();
+	return 0;
+}
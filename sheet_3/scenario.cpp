@@ -0,0 +1,173 @@
+#include "scenario.hpp"
+#include "initial_conditions.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+
+double scenario::estimated_cost() const {
+	/*
+	 * Number of steps times the pair evaluations per step. For adaptive time steps the initial time step is used as a guess.
+	 */
+	double steps = (time_step > 0.) ? final_time/time_step : 0.;
+	double n = bodies.size();
+
+	return steps * (n*n + n*test_particles.size() + 1.);
+}
+
+
+std::unique_ptr<generic_n_body> scenario::create_solver() const {
+
+	std::unique_ptr<generic_n_body> solver;
+
+	if (integrator == "leapfrog") { solver.reset(new leapfrog_n_body(0., output_file_name)); }
+	else if (integrator == "rk2") { solver.reset(new rk2_n_body(0., output_file_name)); }
+	else { throw std::runtime_error("unknown integrator '" + integrator + "' in scenario " + output_file_name); }
+
+	solver->enable_regularization(regularization_radius);
+	solver->add_objects(bodies);
+	solver->add_test_particles(test_particles);
+
+	return solver;
+}
+
+
+void scenario::run() const {
+	create_solver()->simulate(final_time, time_step, output_time, adaptive_steps);
+}
+
+
+static void generate(std::istringstream & line, std::vector<body> & target) {
+	/*
+	 * Calls the generator named by the first word of line with the remaining parameters.
+	 */
+	std::string generator;
+	unsigned int count = 0;
+	std::uint64_t seed = 0;
+	line >> generator >> count;
+
+	if (generator == "plummer") {
+		double total_mass, scale_radius;
+		line >> total_mass >> scale_radius >> seed;
+		if (line.fail()) { throw std::runtime_error("expected: plummer count total_mass scale_radius seed"); }
+		plummer_sphere(target, count, total_mass, scale_radius, seed);
+	}
+	else if (generator == "king") {
+		double total_mass, core_radius, w0;
+		line >> total_mass >> core_radius >> w0 >> seed;
+		if (line.fail()) { throw std::runtime_error("expected: king count total_mass core_radius w0 seed"); }
+		king_sphere(target, count, total_mass, core_radius, w0, seed);
+	}
+	else if (generator == "uniform_sphere") {
+		double total_mass, radius, max_velocity;
+		line >> total_mass >> radius >> max_velocity >> seed;
+		if (line.fail()) { throw std::runtime_error("expected: uniform_sphere count total_mass radius max_velocity seed"); }
+		uniform_sphere(target, count, total_mass, radius, max_velocity, seed);
+	}
+	else if (generator == "disk") {
+		double disk_mass, central_mass, inner_radius, outer_radius, scale_height;
+		line >> disk_mass >> central_mass >> inner_radius >> outer_radius >> scale_height >> seed;
+		if (line.fail()) { throw std::runtime_error("expected: disk count disk_mass central_mass inner_radius outer_radius scale_height seed"); }
+		disk(target, count, disk_mass, central_mass, inner_radius, outer_radius, scale_height, seed);
+	}
+	else if (generator == "keplerian") {
+		double body_mass, central_mass, min_a, max_a, max_eccentricity, max_inclination;
+		line >> body_mass >> central_mass >> min_a >> max_a >> max_eccentricity >> max_inclination >> seed;
+		if (line.fail()) { throw std::runtime_error("expected: keplerian count body_mass central_mass min_a max_a max_eccentricity max_inclination seed"); }
+		keplerian_orbits(target, count, body_mass, central_mass, min_a, max_a, max_eccentricity, max_inclination, seed);
+	}
+	else {
+		throw std::runtime_error("unknown generator '" + generator + "'");
+	}
+}
+
+
+std::vector<scenario> read_scenario_file(const std::string & file_name) {
+
+	std::ifstream file (file_name);
+	if (!file) { throw std::runtime_error("cannot open scenario file " + file_name); }
+
+	std::vector<scenario> scenarios;
+	bool inside = false;
+	std::string text;
+	int line_number = 0;
+
+	while (std::getline(file, text)) {
+		line_number++;
+
+		// strip comments
+		std::size_t comment = text.find('#');
+		if (comment != std::string::npos) { text.erase(comment); }
+
+		std::istringstream line (text);
+		std::string keyword;
+		if (!(line >> keyword)) { continue; }
+
+		try {
+			if (keyword == "scenario") {
+				if (inside) { throw std::runtime_error("missing 'end' of the previous scenario"); }
+				scenarios.push_back(scenario());
+				if (!(line >> scenarios.back().output_file_name)) { throw std::runtime_error("expected: scenario output_file"); }
+
+				// scenarios run concurrently, two of them would write the same file
+				for (std::size_t i=0; i+1<scenarios.size(); i++) {
+					if (scenarios[i].output_file_name == scenarios.back().output_file_name) {
+						throw std::runtime_error("output file " + scenarios.back().output_file_name + " is used by another scenario");
+					}
+				}
+				inside = true;
+				continue;
+			}
+			if (!inside) { throw std::runtime_error("'" + keyword + "' outside of a scenario"); }
+
+			scenario & current = scenarios.back();
+
+			if (keyword == "end") {
+				if (current.time_step <= 0.) { throw std::runtime_error("scenario " + current.output_file_name + " has no 'simulate' line"); }
+				inside = false;
+			}
+			else if (keyword == "integrator") {
+				line >> current.integrator;
+			}
+			else if (keyword == "simulate") {
+				int adaptive = 0;
+				line >> current.final_time >> current.time_step >> current.output_time >> adaptive;
+				if (line.fail() || current.time_step <= 0.) { throw std::runtime_error("expected: simulate final_time time_step output_time adaptive"); }
+				current.adaptive_steps = (adaptive != 0);
+			}
+			else if (keyword == "regularize") {
+				line >> current.regularization_radius;
+				if (line.fail() || current.regularization_radius < 0.) { throw std::runtime_error("expected: regularize close_radius"); }
+			}
+			else if (keyword == "body" || keyword == "test_particle") {
+				double x, y, z, vx, vy, vz, mass = 0.;
+				line >> x >> y >> z >> vx >> vy >> vz;
+				if (keyword == "body") { line >> mass; }
+				if (line.fail()) { throw std::runtime_error("expected: " + keyword + " x y z vx vy vz" + (keyword == "body" ? " mass" : "")); }
+
+				body object (cartesian_vector(x, y, z), cartesian_vector(vx, vy, vz), mass);
+				if (keyword == "body") { current.bodies.push_back(object); }
+				else { current.test_particles.push_back(object); }
+			}
+			else if (keyword == "generate") {
+				generate(line, current.bodies);
+			}
+			else if (keyword == "generate_test_particles") {
+				generate(line, current.test_particles);
+			}
+			else {
+				throw std::runtime_error("unknown keyword '" + keyword + "'");
+			}
+		}
+		catch (std::runtime_error & error) {
+			std::ostringstream message;
+			message << file_name << ":" << line_number << ": " << error.what();
+			throw std::runtime_error(message.str());
+		}
+	}
+
+	if (inside) { throw std::runtime_error(file_name + ": missing 'end' of the last scenario"); }
+
+	return scenarios;
+}
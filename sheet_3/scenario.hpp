@@ -0,0 +1,57 @@
+/* FILE SCENARIO.HPP */
+#ifndef FILE_SCENARIO_HPP
+#define FILE_SCENARIO_HPP
+
+#include "n-body.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+ * Description of a single simulation run, read from a scenario file.
+ *
+ * Scenario file format (one keyword per line, everything after a '#' is a comment):
+ *
+ *	scenario <output file>                           starts a new scenario
+ *	integrator <leapfrog|rk2>
+ *	simulate <final_time> <time_step> <output_time> <adaptive (0 or 1)>
+ *	regularize <close_radius>                        see generic_n_body::enable_regularization
+ *	body <x> <y> <z> <vx> <vy> <vz> <mass>
+ *	test_particle <x> <y> <z> <vx> <vy> <vz>
+ *	generate <generator> <parameters...>             bodies from initial_conditions.hpp
+ *	generate_test_particles <generator> <parameters...>
+ *	end                                              finishes the scenario
+ *
+ * The generator parameters follow the order of the functions in initial_conditions.hpp (without the std::vector), e.g.:
+ *	generate plummer <count> <total_mass> <scale_radius> <seed>
+ *	generate king <count> <total_mass> <core_radius> <w0> <seed>
+ *	generate uniform_sphere <count> <total_mass> <radius> <max_velocity> <seed>
+ *	generate disk <count> <disk_mass> <central_mass> <inner_radius> <outer_radius> <scale_height> <seed>
+ *	generate keplerian <count> <body_mass> <central_mass> <min_a> <max_a> <max_eccentricity> <max_inclination> <seed>
+ *
+ * See scenarios.txt for the scenarios of main.cpp in this format.
+ */
+class scenario {
+	public:
+		std::string output_file_name;
+		std::string integrator = "leapfrog";
+		double final_time = 0., time_step = 0., output_time = 0.;
+		bool adaptive_steps = false;
+		double regularization_radius = 0.;
+
+		std::vector<body> bodies;
+		std::vector<body> test_particles;
+
+		// rough number of pair evaluations of the whole run, used to schedule long runs first
+		double estimated_cost() const;
+
+		// creates the solver with all bodies and test particles, the simulation is started with run()
+		std::unique_ptr<generic_n_body> create_solver() const;
+		void run() const;
+};
+
+// throws std::runtime_error (including the line number) if the file cannot be read or contains an invalid line
+std::vector<scenario> read_scenario_file(const std::string & file_name);
+
+#endif /* FILE_SCENARIO_HPP */
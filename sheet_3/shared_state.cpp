@@ -0,0 +1,214 @@
+#include "shared_state.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+static std::size_t slot_size_for(unsigned int capacity) {
+	// slot header and 7 arrays of capacity doubles, rounded up to whole cache lines
+	std::size_t size = 64 + 7*sizeof(double)*capacity;
+	return (size + 63)/64*64;
+}
+
+
+static const double * slot_array(const shared_state_slot * slot, unsigned int capacity, int array) {
+	return reinterpret_cast<const double *>(reinterpret_cast<const char *>(slot) + 64) + array*capacity;
+}
+
+
+state_publisher::state_publisher (const std::string & name, unsigned int capacity, unsigned int slot_count) : name(name) {
+
+	// the frames are stored round-robin in frame % slot_count
+	if (slot_count == 0) { throw std::runtime_error("state_publisher: " + name + " needs at least one slot"); }
+
+	slot_size = slot_size_for(capacity);
+	length = 64 + slot_count*slot_size;
+
+	int descriptor = shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+	if (descriptor < 0) { throw std::runtime_error("state_publisher: cannot create shared memory " + name); }
+
+	if (ftruncate(descriptor, length) != 0) {
+		close(descriptor);
+		shm_unlink(name.c_str());
+		throw std::runtime_error("state_publisher: cannot resize shared memory " + name);
+	}
+
+	void * mapping = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+	close(descriptor);
+	if (mapping == MAP_FAILED) {
+		shm_unlink(name.c_str());
+		throw std::runtime_error("state_publisher: cannot map shared memory " + name);
+	}
+	data = static_cast<char *>(mapping);
+
+	// the segment is zero filled, the atomics are constructed in place
+	for (unsigned int s=0; s<slot_count; s++) {
+		shared_state_slot * slot = new (data + 64 + s*slot_size) shared_state_slot;
+		slot->sequence.store(0, std::memory_order_relaxed);
+	}
+
+	header = new (data) shared_state_header;
+	header->version = 1;
+	header->slot_count = slot_count;
+	header->capacity = capacity;
+	header->published.store(0, std::memory_order_relaxed);
+
+	// readers check the magic last
+	std::atomic_thread_fence(std::memory_order_release);
+	std::memcpy(header->magic, "NBODYSHM", 8);
+}
+
+
+state_publisher::~state_publisher() {
+	munmap(data, length);
+	shm_unlink(name.c_str());
+}
+
+
+bool state_publisher::publish(double time, double energy, const std::vector<body> & bodies) {
+	/*
+	 * Sequence lock writer: mark the slot as being written (odd sequence number), write, mark it as complete (even).
+	 * Readers never modify the segment, so this never waits.
+	 */
+	const unsigned int capacity = header->capacity;
+	if (bodies.size() > capacity) { return false; }
+
+	std::uint64_t frame = header->published.load(std::memory_order_relaxed);
+	shared_state_slot * slot = reinterpret_cast<shared_state_slot *>(data + 64 + (frame % header->slot_count)*slot_size);
+
+	std::uint64_t sequence = slot->sequence.load(std::memory_order_relaxed);
+	slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	slot->frame = frame;
+	slot->time = time;
+	slot->energy = energy;
+	slot->body_count = bodies.size();
+
+	double * arrays = reinterpret_cast<double *>(reinterpret_cast<char *>(slot) + 64);
+	for (unsigned int i=0; i<bodies.size(); i++) {
+		arrays[i] = bodies[i].position.x;
+		arrays[capacity + i] = bodies[i].position.y;
+		arrays[2*capacity + i] = bodies[i].position.z;
+		arrays[3*capacity + i] = bodies[i].velocity.x;
+		arrays[4*capacity + i] = bodies[i].velocity.y;
+		arrays[5*capacity + i] = bodies[i].velocity.z;
+		arrays[6*capacity + i] = bodies[i].mass;
+	}
+
+	slot->sequence.store(sequence + 2, std::memory_order_release);
+	header->published.store(frame + 1, std::memory_order_release);
+	return true;
+}
+
+
+state_subscriber::state_subscriber (const std::string & name) {
+
+	int descriptor = shm_open(name.c_str(), O_RDONLY, 0);
+	if (descriptor < 0) { throw std::runtime_error("state_subscriber: no shared memory " + name); }
+
+	struct stat status;
+	if (fstat(descriptor, &status) != 0 || status.st_size < 64) {
+		close(descriptor);
+		throw std::runtime_error("state_subscriber: shared memory " + name + " is not initialized");
+	}
+	length = status.st_size;
+
+	void * mapping = mmap(nullptr, length, PROT_READ, MAP_SHARED, descriptor, 0);
+	close(descriptor);
+	if (mapping == MAP_FAILED) { throw std::runtime_error("state_subscriber: cannot map shared memory " + name); }
+	data = static_cast<const char *>(mapping);
+
+	header = reinterpret_cast<const shared_state_header *>(data);
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (std::memcmp(header->magic, "NBODYSHM", 8) != 0 || header->version != 1 || header->slot_count == 0
+			|| length < 64 + header->slot_count*slot_size_for(header->capacity)) {
+		munmap(const_cast<char *>(data), length);
+		throw std::runtime_error("state_subscriber: shared memory " + name + " has an unknown layout");
+	}
+
+	slot_size = slot_size_for(header->capacity);
+}
+
+
+state_subscriber::~state_subscriber() {
+	munmap(const_cast<char *>(data), length);
+}
+
+
+std::uint64_t state_subscriber::published() const {
+	return header->published.load(std::memory_order_acquire);
+}
+
+
+const shared_state_slot * state_subscriber::slot(std::uint64_t frame) const {
+	return reinterpret_cast<const shared_state_slot *>(data + 64 + (frame % header->slot_count)*slot_size);
+}
+
+
+bool state_subscriber::view(std::uint64_t frame, state_view & result) const {
+	/*
+	 * Fails if the frame is not published yet, already overwritten or currently being overwritten.
+	 */
+	if (frame >= published()) { return false; }
+
+	const shared_state_slot * target = slot(frame);
+	std::uint64_t sequence = target->sequence.load(std::memory_order_acquire);
+	if (sequence % 2 == 1 || target->frame != frame) { return false; }
+
+	const unsigned int capacity = header->capacity;
+	result.frame = frame;
+	result.sequence = sequence;
+	result.time = target->time;
+	result.energy = target->energy;
+	result.body_count = std::min<std::uint32_t>(target->body_count, capacity);
+	result.x = slot_array(target, capacity, 0); result.y = slot_array(target, capacity, 1); result.z = slot_array(target, capacity, 2);
+	result.vx = slot_array(target, capacity, 3); result.vy = slot_array(target, capacity, 4); result.vz = slot_array(target, capacity, 5);
+	result.mass = slot_array(target, capacity, 6);
+	result.slot = target;
+
+	return valid(result);
+}
+
+
+bool state_subscriber::valid(const state_view & view) const {
+	// everything read before must not be reordered after the check of the sequence number
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return view.slot != nullptr && view.slot->sequence.load(std::memory_order_relaxed) == view.sequence;
+}
+
+
+bool state_subscriber::read(std::uint64_t frame, state_frame & result) const {
+	state_view source;
+	if (!view(frame, source)) { return false; }
+
+	unsigned int n = source.body_count;
+	result.frame = source.frame;
+	result.time = source.time;
+	result.energy = source.energy;
+	result.x.assign(source.x, source.x + n); result.y.assign(source.y, source.y + n); result.z.assign(source.z, source.z + n);
+	result.vx.assign(source.vx, source.vx + n); result.vy.assign(source.vy, source.vy + n); result.vz.assign(source.vz, source.vz + n);
+	result.mass.assign(source.mass, source.mass + n);
+
+	return valid(source);
+}
+
+
+bool state_subscriber::read_latest(state_frame & result) const {
+	/*
+	 * Retries with the newest frame if the writer overwrote the slot during the copy.
+	 */
+	for (int attempt=0; attempt<16; attempt++) {
+		std::uint64_t count = published();
+		if (count == 0) { return false; }
+		if (read(count - 1, result)) { return true; }
+	}
+	return false;
+}
@@ -0,0 +1,118 @@
+/* FILE SHARED_STATE.HPP */
+#ifndef FILE_SHARED_STATE_HPP
+#define FILE_SHARED_STATE_HPP
+
+#include "body.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Live access to the simulation state from other processes through a POSIX shared memory ring (shm_open, e.g. "/nbody_live").
+ *
+ * The publisher (the simulation, see generic_n_body::attach_publisher) writes every frame into the next of slot_count slots and
+ * overwrites the oldest one, it never waits for a reader. Every slot is protected by a sequence lock: the sequence number is odd
+ * while the slot is written, a reader copies (or directly uses) the data and accepts it only if the sequence number was even and
+ * unchanged during the read. A reader that is too slow simply misses frames.
+ *
+ * Memory layout (all blocks aligned to 64 bytes, native byte order, so that e.g. numpy.frombuffer can use the segment as well):
+ *	header (64 bytes): char magic[8] = "NBODYSHM", uint32 version = 1, uint32 slot_count, uint32 capacity (bodies per slot),
+ *	                   uint32 padding, uint64 published (number of published frames, atomic)
+ *	slot_count slots of slot_size bytes: header (64 bytes): uint64 sequence (atomic), uint64 frame, double time, double energy,
+ *	                   uint32 body_count; then the arrays x, y, z, vx, vy, vz, mass with capacity doubles each
+ */
+
+class shared_state_header {
+	public:
+		char magic[8];
+		std::uint32_t version, slot_count, capacity, padding;
+		std::atomic<std::uint64_t> published;
+};
+
+class shared_state_slot {
+	public:
+		std::atomic<std::uint64_t> sequence;
+		std::uint64_t frame;
+		double time, energy;
+		std::uint32_t body_count;
+};
+
+
+class state_publisher {
+	public:
+		// creates (or replaces) the shared memory segment for up to capacity bodies
+		state_publisher (const std::string & name, unsigned int capacity, unsigned int slot_count = 8);
+		~state_publisher();
+
+		state_publisher (const state_publisher &) = delete;
+		state_publisher & operator = (const state_publisher &) = delete;
+
+		// writes the next frame, returns false (and publishes nothing) if there are more bodies than the capacity
+		bool publish(double time, double energy, const std::vector<body> & bodies);
+
+	private:
+		std::string name;
+		char * data = nullptr;
+		std::size_t length = 0, slot_size = 0;
+		shared_state_header * header = nullptr;
+};
+
+
+/*
+ * Copy of a frame (structure of arrays as in the shared memory).
+ */
+class state_frame {
+	public:
+		std::uint64_t frame = 0;
+		double time = 0., energy = 0.;
+		std::vector<double> x, y, z, vx, vy, vz, mass;
+
+		unsigned int body_count() const { return x.size(); }
+};
+
+/*
+ * Zero-copy access to a slot: the pointers refer to the shared memory, the data is only consistent if
+ * state_subscriber::valid(view) returns true after it was used.
+ */
+class state_view {
+	public:
+		std::uint64_t frame = 0, sequence = 0;
+		double time = 0., energy = 0.;
+		unsigned int body_count = 0;
+		const double * x = nullptr, * y = nullptr, * z = nullptr, * vx = nullptr, * vy = nullptr, * vz = nullptr, * mass = nullptr;
+		const shared_state_slot * slot = nullptr;
+};
+
+
+class state_subscriber {
+	public:
+		// attaches read-only to an existing segment (std::runtime_error if it does not exist)
+		state_subscriber (const std::string & name);
+		~state_subscriber();
+
+		state_subscriber (const state_subscriber &) = delete;
+		state_subscriber & operator = (const state_subscriber &) = delete;
+
+		// number of frames published so far, the latest frame is published() - 1
+		std::uint64_t published() const;
+
+		// copies the given frame, false if it was already overwritten (or is not yet published)
+		bool read(std::uint64_t frame, state_frame & result) const;
+		bool read_latest(state_frame & result) const;
+
+		// zero-copy variant of read, use valid() after processing the data
+		bool view(std::uint64_t frame, state_view & result) const;
+		bool valid(const state_view & view) const;
+
+	private:
+		const char * data = nullptr;
+		std::size_t length = 0, slot_size = 0;
+		const shared_state_header * header = nullptr;
+
+		const shared_state_slot * slot(std::uint64_t frame) const;
+};
+
+#endif /* FILE_SHARED_STATE_HPP */
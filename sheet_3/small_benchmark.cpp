@@ -0,0 +1,83 @@
+#include "n-body.hpp"
+#include "small_n_body.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+ * Compares the steps per second of leapfrog_n_body and small_n_body<N> on the two body (task_b) and three body (task_c) systems.
+ *
+ * Usage: ./small_benchmark.out [steps]
+ *
+ * Both write 10 snapshots, the largest difference between the last snapshots is printed as a consistency check
+ * (the pair sums are added in a different order, in the three body system the rounding differences grow exponentially
+ * after the close encounters, so they only agree to ~1e-13 for short runs, e.g. 20000 steps).
+ */
+
+static std::vector<double> last_line(const std::string & file_name) {
+	std::ifstream file (file_name);
+	std::string line, last;
+	while (std::getline(file, line)) { if (!line.empty()) { last = line; } }
+
+	std::istringstream values (last);
+	std::vector<double> result;
+	double value;
+	while (values >> value) { result.push_back(value); }
+	return result;
+}
+
+
+template <int N>
+static void compare(const std::string & name, const std::array<body, N> & bodies, double time_step, long steps) {
+
+	const double final_time = steps*time_step, output_time = final_time/10;
+
+	leapfrog_n_body generic (0., name + "_generic.dat");
+	for (int i=0; i<N; i++) { generic.add_object(bodies[i]); }
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	generic.simulate(final_time, time_step, output_time, false);
+	double generic_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	small_n_body<N> small (0., name + "_small.dat");
+	for (int i=0; i<N; i++) { small.set_object(i, bodies[i]); }
+
+	start = std::chrono::steady_clock::now();
+	small.simulate(final_time, time_step, output_time);
+	double small_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::vector<double> generic_state = last_line(name + "_generic.dat"), small_state = last_line(name + "_small.dat");
+	double difference = (generic_state.size() == small_state.size()) ? 0. : INFINITY;
+	for (unsigned int k=0; k<std::min(generic_state.size(), small_state.size()); k++) {
+		difference = std::max(difference, std::abs(generic_state[k] - small_state[k]));
+	}
+
+	std::cout << name << " (" << N << " bodies, " << steps << " steps):" << std::endl;
+	std::cout << "\tleapfrog_n_body: " << steps/generic_seconds << " steps/s" << std::endl;
+	std::cout << "\tsmall_n_body:    " << steps/small_seconds << " steps/s (" << generic_seconds/small_seconds << "x)" << std::endl;
+	std::cout << "\tlargest difference of the final snapshots: " << difference << std::endl;
+}
+
+
+int main(int argc, char **argv) {
+	long steps = (argc > 1) ? std::atol(argv[1]) : 2000000;
+
+	std::array<body, 2> task_b = {{
+		body(cartesian_vector(-.5, 0., 0.), cartesian_vector(0., -.5, 0.), 1.),
+		body(cartesian_vector(.5, 0., 0.), cartesian_vector(0., .5, 0.), 1.) }};
+
+	std::array<body, 3> task_c = {{
+		body(cartesian_vector(-.5, 0., 0.), cartesian_vector(0., -.5, 0.), 1.),
+		body(cartesian_vector(.5, 0., 0.), cartesian_vector(0., .5, 0.), 1.),
+		body(cartesian_vector(1., 6., 2.), cartesian_vector(0., 0., 0.), .1) }};
+
+	compare<2>("task_b", task_b, 0.001, steps);
+	compare<3>("task_c", task_c, 0.001, steps);
+
+	return 0;
+}
@@ -0,0 +1,164 @@
+/* FILE SMALL_N_BODY.HPP */
+#ifndef FILE_SMALL_N_BODY_HPP
+#define FILE_SMALL_N_BODY_HPP
+
+#include "vector.hpp"
+#include "body.hpp"
+
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <string>
+
+/*
+ * Leap frog integration of a system with a fixed number N of bodies (known at compile time), for the tiny systems of the exercises
+ * (two and three bodies, task_e with five).
+ *
+ * Unlike generic_n_body the state is stored in std::array members (one per component), there is no virtual step() and no
+ * cartesian_vector arithmetic (which is not inlined). The N(N-1)/2 pair interactions are expanded at compile time by template
+ * recursion over the pair index, every pair contributes to both bodies (Newton's third law), so the force loop has no loop
+ * bounds, no branches and only half of the square roots of the generic version.
+ *
+ * The interface and the output file follow generic_n_body (time energy position1 velocity1 ...), for constant time steps:
+ *	small_n_body<3> solver (0., "task_c.dat");
+ *	solver.set_object(0, body(...)); ...
+ *	solver.simulate(50, 0.001, 0.1);
+ */
+
+// first and second body of the pair with the index k (pairs ordered as (0,1), (0,2), ..., (1,2), ...)
+constexpr int pair_first(int k, int n, int i = 0) { return (k < n-1-i) ? i : pair_first(k - (n-1-i), n, i + 1); }
+constexpr int pair_second(int k, int n, int i = 0) { return (k < n-1-i) ? i + 1 + k : pair_second(k - (n-1-i), n, i + 1); }
+
+
+template <int N, int K, bool done = (K == N*(N-1)/2)>
+struct unrolled_pairs {
+	template <class system>
+	static inline void apply(system & s) {
+		s.template interact<pair_first(K, N), pair_second(K, N)>();
+		unrolled_pairs<N, K + 1>::apply(s);
+	}
+};
+
+template <int N, int K>
+struct unrolled_pairs<N, K, true> {
+	template <class system>
+	static inline void apply(system &) { }
+};
+
+
+template <int N>
+class small_n_body {
+	public:
+		small_n_body (double initial_time, std::string out_file_name) : time(initial_time), output_file_name(out_file_name) {
+			x.fill(0.); y.fill(0.); z.fill(0.); vx.fill(0.); vy.fill(0.); vz.fill(0.); mass.fill(0.);
+
+			// clear the output file
+			output_file.open(output_file_name, std::ios::out | std::ios::trunc);
+			output_file << std::setprecision(14);
+			output_file.close();
+		}
+
+		void set_object(int index, body object) {
+			x[index] = object.position.x; y[index] = object.position.y; z[index] = object.position.z;
+			vx[index] = object.velocity.x; vy[index] = object.velocity.y; vz[index] = object.velocity.z;
+			mass[index] = object.mass;
+		}
+
+		body get_object(int index) const {
+			return body(cartesian_vector(x[index], y[index], z[index]), cartesian_vector(vx[index], vy[index], vz[index]), mass[index]);
+		}
+
+		void simulate(double final_time, double time_step, double output_time) {
+			/*
+			 * Same time stepping and output as generic_n_body::simulate with constant time steps.
+			 */
+			output_file.open(output_file_name, std::ios::out | std::ios::app);
+
+			calculate_accelerations();
+
+			unsigned int output_counter = 1;
+			const double dt = time_step;
+
+			while (time < final_time) {
+				time_step = dt;
+
+				if (output_time != 0) {
+					if (time == output_counter * output_time) {
+						write_state();
+						output_counter ++;
+					}
+
+					// adjust the time step if necessary, so that no output step is missed
+					if (time + time_step > output_counter * output_time) { time_step = (output_counter * output_time) - time; }
+				}
+				else { write_state(); }
+
+				step(time_step);
+				time += time_step;
+			}
+
+			output_file.close();
+		}
+
+		double calculate_total_energy() const {
+			double energy = 0.;
+			for (int i=0; i<N; i++) {
+				energy += .5*mass[i]*(vx[i]*vx[i] + vy[i]*vy[i] + vz[i]*vz[i]);
+				for (int j=0; j<i; j++) {
+					double dx = x[j] - x[i], dy = y[j] - y[i], dz = z[j] - z[i];
+					energy -= mass[i]*mass[j]/std::sqrt(dx*dx + dy*dy + dz*dz);
+				}
+			}
+			return energy;
+		}
+
+		// single pair interaction, called by unrolled_pairs for all pairs i < j
+		template <int i, int j>
+		inline void interact() {
+			double dx = x[j] - x[i], dy = y[j] - y[i], dz = z[j] - z[i];
+			double inverse_distance = 1./std::sqrt(dx*dx + dy*dy + dz*dz);
+			double inverse_cube = inverse_distance*inverse_distance*inverse_distance;
+
+			ax[i] += mass[j]*inverse_cube*dx; ay[i] += mass[j]*inverse_cube*dy; az[i] += mass[j]*inverse_cube*dz;
+			ax[j] -= mass[i]*inverse_cube*dx; ay[j] -= mass[i]*inverse_cube*dy; az[j] -= mass[i]*inverse_cube*dz;
+		}
+
+	private:
+		double time;
+		std::ofstream output_file;
+		std::string output_file_name;
+		std::array<double, N> x, y, z, vx, vy, vz, ax, ay, az, mass;
+
+		void calculate_accelerations() {
+			ax.fill(0.); ay.fill(0.); az.fill(0.);
+			unrolled_pairs<N, 0>::apply(*this);
+		}
+
+		void step(double time_step) {
+			// update positions and first half of velocities
+			for (int i=0; i<N; i++) {
+				x[i] += time_step*vx[i] + .5*time_step*time_step*ax[i];
+				y[i] += time_step*vy[i] + .5*time_step*time_step*ay[i];
+				z[i] += time_step*vz[i] + .5*time_step*time_step*az[i];
+				vx[i] += .5*time_step*ax[i]; vy[i] += .5*time_step*ay[i]; vz[i] += .5*time_step*az[i];
+			}
+
+			calculate_accelerations();
+
+			// second half of the velocities
+			for (int i=0; i<N; i++) {
+				vx[i] += .5*time_step*ax[i]; vy[i] += .5*time_step*ay[i]; vz[i] += .5*time_step*az[i];
+			}
+		}
+
+		void write_state() {
+			output_file << time << ' ' << calculate_total_energy() << ' ';
+			for (int i=0; i<N; i++) {
+				output_file << x[i] << ' ' << y[i] << ' ' << z[i] << ' ' << vx[i] << ' ' << vy[i] << ' ' << vz[i] << ' ';
+			}
+			output_file << std::endl;
+		}
+};
+
+#endif /* FILE_SMALL_N_BODY_HPP */
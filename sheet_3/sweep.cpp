@@ -0,0 +1,126 @@
+#include "scenario.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include <omp.h>
+
+/*
+ * Parameter sweep runner: executes all scenarios of a scenario file (see scenario.hpp) concurrently.
+ *
+ * Usage: ./sweep.out scenario_file [worker_count]
+ *
+ * Every worker thread owns a double ended queue of scenarios. The scenarios are sorted by their estimated cost and dealt
+ * round robin, so that every worker starts with its longest run. A worker takes its own scenarios from the front (longest first),
+ * a worker without scenarios steals from the back of the other queues (the shortest remaining ones). Thereby the long runs
+ * start early and the short runs fill the gaps at the end.
+ */
+
+class work_queue {
+	public:
+		std::deque<unsigned int> tasks;
+		std::mutex lock;
+
+		bool pop_front(unsigned int & task) {
+			std::lock_guard<std::mutex> guard (lock);
+			if (tasks.empty()) { return false; }
+			task = tasks.front(); tasks.pop_front();
+			return true;
+		}
+
+		bool pop_back(unsigned int & task) {
+			std::lock_guard<std::mutex> guard (lock);
+			if (tasks.empty()) { return false; }
+			task = tasks.back(); tasks.pop_back();
+			return true;
+		}
+};
+
+
+int main(int argc, char **argv) {
+	if (argc != 2 && argc != 3) {
+		std::cerr << "Usage: ./sweep.out scenario_file [worker_count]" << std::endl;
+		return 1;
+	}
+
+	std::vector<scenario> scenarios;
+	try {
+		scenarios = read_scenario_file(argv[1]);
+	}
+	catch (std::exception & error) {
+		std::cerr << error.what() << std::endl;
+		return 1;
+	}
+
+	unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+	unsigned int worker_count = cores;
+	if (argc == 3) {
+		std::istringstream iss(argv[2]);
+		iss >> worker_count;
+	}
+	worker_count = std::max(1u, std::min(worker_count, (unsigned int) scenarios.size()));
+
+	// the remaining cores are used by the OpenMP loops inside of each simulation
+	int threads_per_worker = std::max(1u, cores / worker_count);
+
+	// longest runs first, dealt round robin
+	std::vector<unsigned int> order (scenarios.size());
+	for (unsigned int i=0; i<order.size(); i++) { order[i] = i; }
+	std::stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) { return scenarios[a].estimated_cost() > scenarios[b].estimated_cost(); });
+
+	std::vector<work_queue> queues (worker_count);
+	for (unsigned int i=0; i<order.size(); i++) {
+		queues[i % worker_count].tasks.push_back(order[i]);
+	}
+
+	std::mutex print_lock;
+	int failures = 0;
+
+	auto worker = [&](unsigned int id) {
+		omp_set_num_threads(threads_per_worker);
+
+		unsigned int task;
+		while (true) {
+			bool found = queues[id].pop_front(task);
+
+			// steal from the other workers, starting with the next one
+			for (unsigned int k=1; !found && k<worker_count; k++) {
+				found = queues[(id + k) % worker_count].pop_back(task);
+			}
+			// no queue contains work anymore (scenarios are never added after the start)
+			if (!found) { return; }
+
+			auto start = std::chrono::steady_clock::now();
+			std::string error;
+			try { scenarios[task].run(); }
+			catch (std::exception & exc) { error = exc.what(); }
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			std::lock_guard<std::mutex> guard (print_lock);
+			if (error.empty()) {
+				std::cout << "worker " << id << " finished " << scenarios[task].output_file_name << " in " << seconds << " s" << std::endl;
+			}
+			else {
+				std::cerr << "worker " << id << " failed " << scenarios[task].output_file_name << ": " << error << std::endl;
+				failures++;
+			}
+		}
+	};
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> workers;
+	for (unsigned int id=0; id<worker_count; id++) { workers.push_back(std::thread(worker, id)); }
+	for (unsigned int id=0; id<worker_count; id++) { workers[id].join(); }
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << scenarios.size() << " scenarios on " << worker_count << " workers in " << seconds << " s" << std::endl;
+
+	return (failures == 0) ? 0 : 1;
+}
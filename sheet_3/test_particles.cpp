@@ -0,0 +1,139 @@
+#include "test_particles.hpp"
+#include "gravity_kernel.hpp"
+
+
+void test_particle_set::add(cartesian_vector position, cartesian_vector velocity) {
+	/*
+	 * Appends a new test particle, its acceleration is set to zero until the next call of calculate_accelerations.
+	 */
+	x.push_back(position.x); y.push_back(position.y); z.push_back(position.z);
+	vx.push_back(velocity.x); vy.push_back(velocity.y); vz.push_back(velocity.z);
+	ax.push_back(0.); ay.push_back(0.); az.push_back(0.);
+}
+
+
+void test_particle_set::calculate_accelerations(const std::vector<body> & sources) {
+	/*
+	 * Calculates the acceleration of every test particle due to the gravity of the bodies in sources:
+	 *
+	 * a_i = sum_j=0^N_massive  ( m_j * (x_j - x_i)/|x_j - x_i|^3 )
+	 *
+	 * The outer loop runs over the test particles and is split between threads and vectorized,
+	 * the inner loop over the (few) massive bodies only reads from the contiguous source arrays.
+	 */
+
+	const int n = size();
+	const int n_sources = sources.size();
+
+	source_x.resize(n_sources); source_y.resize(n_sources); source_z.resize(n_sources); source_mass.resize(n_sources);
+	for (int j=0; j<n_sources; j++) {
+		source_x[j] = sources[j].position.x;
+		source_y[j] = sources[j].position.y;
+		source_z[j] = sources[j].position.z;
+		source_mass[j] = sources[j].mass;
+	}
+
+	const double * sx = source_x.data(), * sy = source_y.data(), * sz = source_z.data(), * sm = source_mass.data();
+	const double * px = x.data(), * py = y.data(), * pz = z.data();
+	double * pax = ax.data(), * pay = ay.data(), * paz = az.data();
+
+	#pragma omp parallel for simd schedule(static)
+	for (int i=0; i<n; i++) {
+		double acc_x = 0., acc_y = 0., acc_z = 0.;
+
+		for (int j=0; j<n_sources; j++) {
+			double dx = sx[j] - px[i], dy = sy[j] - py[i], dz = sz[j] - pz[i], potential;
+			double factor = direct_kernel(dx, dy, dz, sm[j], potential);
+
+			acc_x += factor * dx;
+			acc_y += factor * dy;
+			acc_z += factor * dz;
+		}
+
+		pax[i] = acc_x; pay[i] = acc_y; paz[i] = acc_z;
+	}
+}
+
+
+void test_particle_set::drift(double time_step) {
+	const int n = size();
+	double * px = x.data(), * py = y.data(), * pz = z.data();
+	const double * pvx = vx.data(), * pvy = vy.data(), * pvz = vz.data();
+
+	#pragma omp parallel for simd schedule(static)
+	for (int i=0; i<n; i++) {
+		px[i] += time_step * pvx[i];
+		py[i] += time_step * pvy[i];
+		pz[i] += time_step * pvz[i];
+	}
+}
+
+
+void test_particle_set::drift_accelerated(double time_step) {
+	const int n = size();
+	const double half_step_squared = .5*time_step*time_step;
+	double * px = x.data(), * py = y.data(), * pz = z.data();
+	const double * pvx = vx.data(), * pvy = vy.data(), * pvz = vz.data();
+	const double * pax = ax.data(), * pay = ay.data(), * paz = az.data();
+
+	#pragma omp parallel for simd schedule(static)
+	for (int i=0; i<n; i++) {
+		px[i] += time_step * pvx[i] + half_step_squared * pax[i];
+		py[i] += time_step * pvy[i] + half_step_squared * pay[i];
+		pz[i] += time_step * pvz[i] + half_step_squared * paz[i];
+	}
+}
+
+
+void test_particle_set::kick(double time_step) {
+	const int n = size();
+	double * pvx = vx.data(), * pvy = vy.data(), * pvz = vz.data();
+	const double * pax = ax.data(), * pay = ay.data(), * paz = az.data();
+
+	#pragma omp parallel for simd schedule(static)
+	for (int i=0; i<n; i++) {
+		pvx[i] += time_step * pax[i];
+		pvy[i] += time_step * pay[i];
+		pvz[i] += time_step * paz[i];
+	}
+}
+
+
+void test_particle_set::predict(double time_step) {
+	/*
+	 * Stores x + dt*v + dt^2/2*a without changing the current positions (required by rk2).
+	 */
+	const int n = size();
+	const double half_step_squared = .5*time_step*time_step;
+
+	x_predicted.resize(n); y_predicted.resize(n); z_predicted.resize(n);
+
+	double * qx = x_predicted.data(), * qy = y_predicted.data(), * qz = z_predicted.data();
+	const double * px = x.data(), * py = y.data(), * pz = z.data();
+	const double * pvx = vx.data(), * pvy = vy.data(), * pvz = vz.data();
+	const double * pax = ax.data(), * pay = ay.data(), * paz = az.data();
+
+	#pragma omp parallel for simd schedule(static)
+	for (int i=0; i<n; i++) {
+		qx[i] = px[i] + time_step * pvx[i] + half_step_squared * pax[i];
+		qy[i] = py[i] + time_step * pvy[i] + half_step_squared * pay[i];
+		qz[i] = pz[i] + time_step * pvz[i] + half_step_squared * paz[i];
+	}
+}
+
+
+void test_particle_set::accept_prediction() {
+	x.swap(x_predicted);
+	y.swap(y_predicted);
+	z.swap(z_predicted);
+}
+
+
+void test_particle_set::write(std::ostream & stream) const {
+	/*
+	 * Writes all test particles in the same way as the massive bodies: position velocity, separated by spaces.
+	 */
+	for (unsigned int i=0; i<size(); i++) {
+		stream << x[i] << ' ' << y[i] << ' ' << z[i] << ' ' << vx[i] << ' ' << vy[i] << ' ' << vz[i] << ' ';
+	}
+}
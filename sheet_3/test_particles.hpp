@@ -0,0 +1,51 @@
+/* FILE TEST_PARTICLES.HPP */
+#ifndef FILE_TEST_PARTICLES_HPP
+#define FILE_TEST_PARTICLES_HPP
+
+#include "vector.hpp"
+#include "body.hpp"
+
+#include <iostream>
+#include <vector>
+
+/*
+ * Massless test particles (tracers).
+ *
+ * Test particles feel the gravity of the massive bodies, but exert none: neither on the massive bodies nor on each other.
+ * Thereby updating them costs O(N_massive * N_test) instead of O(N^2).
+ *
+ * The particles are stored as a structure of arrays (one std::vector per component), so that the update loops
+ * run over contiguous memory and can be vectorized and split between threads.
+ *
+ * The integrators use the following building blocks on all particles at once:
+ *	drift(dt):            x += dt*v
+ *	drift_accelerated(dt): x += dt*v + dt^2/2*a
+ *	kick(dt):             v += dt*a
+ *	predict(dt) / accept_prediction(): store x + dt*v + dt^2/2*a and later replace x with it
+ */
+class test_particle_set {
+	public:
+		std::vector<double> x, y, z, vx, vy, vz, ax, ay, az;
+
+		unsigned int size() const { return x.size(); }
+		void add(cartesian_vector position, cartesian_vector velocity);
+
+		void calculate_accelerations(const std::vector<body> & sources);
+
+		void drift(double time_step);
+		void drift_accelerated(double time_step);
+		void kick(double time_step);
+		void predict(double time_step);
+		void accept_prediction();
+
+		void write(std::ostream & stream) const;
+
+	private:
+		// positions stored by predict()
+		std::vector<double> x_predicted, y_predicted, z_predicted;
+
+		// copy of the massive bodies, so that the force loop only reads contiguous arrays
+		std::vector<double> source_x, source_y, source_z, source_mass;
+};
+
+#endif /* FILE_TEST_PARTICLES_HPP */